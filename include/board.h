@@ -8,7 +8,18 @@
 /* Possibles directions. */
 #define DIRECTIONS 8
 
+/* Symmetries of the board (see bitboard_symmetry ()): a combination of the
+ * flips, the diagonal one first. */
+#define SYMMETRIES 8
+#define SYMMETRY_FLIP_VERTICAL 1
+#define SYMMETRY_FLIP_HORIZONTAL 2
+#define SYMMETRY_FLIP_DIAGONAL 4
+#define SYMMETRY_ROTATE_90 (SYMMETRY_FLIP_DIAGONAL | SYMMETRY_FLIP_HORIZONTAL)
+#define SYMMETRY_ROTATE_180 (SYMMETRY_FLIP_VERTICAL | SYMMETRY_FLIP_HORIZONTAL)
+#define SYMMETRY_ROTATE_270 (SYMMETRY_FLIP_DIAGONAL | SYMMETRY_FLIP_VERTICAL)
+
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,9 +59,59 @@ typedef struct board_t board_t;
 /* Base bitboard type. */
 typedef unsigned __int128 bitboard_t;
 
-/* A SWAR popcount alorithm for bitboard_t. */
+/* Everything needed to undo a move played with board_do_move ()
+ * (store it on the stack of the caller). */
+typedef struct
+{
+    bitboard_t square;
+    bitboard_t flips;
+    bitboard_t moves;
+    uint64_t hash;
+    disc_t player;
+} undo_t;
+
+/* Iterator on the possible moves of a board. It doesn't refer to the board,
+ * so the board can be shared (read-only) or played and undone while iterating
+ * (store it on the stack of the caller). */
+typedef struct
+{
+    bitboard_t moves;
+    size_t size;
+} move_iter_t;
+
+/* Popcount of a bitboard_t (with the POPCNT instruction if the CPU has it,
+ * a SWAR algorithm otherwise). */
 size_t bitboard_popcount (const bitboard_t bitboard);
 
+/* Remove the lowest bit of 'bitboard'
+ *   -> return its index. */
+size_t bitboard_pop_first_bit (bitboard_t *bitboard);
+
+/* Get the possible moves of the discs 'player' against the discs 'opponent'
+ * on a board of size 'size'. */
+bitboard_t bitboard_moves (const size_t size, const bitboard_t player,
+                           const bitboard_t opponent);
+
+/* Get the discs of 'opponent' reversed if 'player' play on the square 'bit'
+ * of a board of size 'size' (0 if it is not a possible move). */
+bitboard_t bitboard_flips (const size_t size, const bitboard_t player,
+                           const bitboard_t opponent, const bitboard_t bit);
+
+/* Apply to 'bitboard' of a board of size 'size' the symmetry 'symmetry' in
+ * [0, SYMMETRIES): a flip on the diagonal (the square (row, column) goes to
+ * (column, row)) if it has SYMMETRY_FLIP_DIAGONAL, then a flip of the rows if
+ * it has SYMMETRY_FLIP_VERTICAL and of the columns if it has
+ * SYMMETRY_FLIP_HORIZONTAL. The rotations are clockwise. */
+bitboard_t bitboard_symmetry (const size_t size, const bitboard_t bitboard,
+                              const unsigned symmetry);
+
+/* Get the symmetry that cancel 'symmetry'. */
+unsigned symmetry_inverse (const unsigned symmetry);
+
+/* Get the image of 'move' by 'symmetry' on a board of size 'size'. */
+move_t move_symmetry (const size_t size, const move_t move,
+                      const unsigned symmetry);
+
 
 /***************************** board_t management *****************************/
 
@@ -65,12 +126,26 @@ size_t board_size (const board_t *board);
 /* Get the current player of the board 'board'. */
 disc_t board_player (const board_t *board);
 
+/* Get the 64 bits Zobrist hash of the board 'board': it covers the board
+ * size, the discs and the current player and it is updated incrementally by
+ * board_set (), board_set_player () and board_play (). */
+uint64_t board_hash (const board_t *board);
+
+/* Get the hash of the canonical form of the board 'board': the smallest of
+ * its images by the symmetries, so all the symmetric boards have the same
+ * one. Store in 'symmetry' (if not NULL) the symmetry from 'board' to its
+ * canonical form. */
+uint64_t board_canonical_hash (const board_t *board, unsigned *symmetry);
+
 /* Set the current player. */
 void board_set_player (board_t *board, disc_t player);
 
 /* Get the content of the square at the given coordinate. */
 disc_t board_get (const board_t *board, const size_t row, const size_t column);
 
+/* Get the squares of the discs 'disc' as a bitboard. */
+bitboard_t board_discs (const board_t *board, const disc_t disc);
+
 /* Set the content of the square at the given coordinate. */
 void board_set (board_t *board, const disc_t disc, const size_t row,
                 const size_t column);
@@ -112,10 +187,31 @@ bool board_is_move_valid (const board_t *board, const move_t move);
  * --> or EMPTY_DISC if nobody can move. */
 bool board_play (board_t *board, const move_t move);
 
-/* Copy the possible moves on this last bitboard
- * and clear the last bit of the bitboard at each call to the board_next_move ()
- * function. */
-move_t board_next_move (board_t *board);
+/* Play a move as board_play () and record in 'undo' the reversed discs and the
+ * previous player and moves
+ *   -> return false (and leave 'undo' unusable) if the move is not valid. */
+bool board_do_move (board_t *board, const move_t move, undo_t *undo);
+
+/* Restore the board as it was before the board_do_move () that filled 'undo'
+ * (moves must be undone in the reverse order they were done). */
+void board_undo_move (board_t *board, const undo_t *undo);
+
+/* Get the possible moves of the current player as a bitboard. */
+bitboard_t board_moves (const board_t *board);
+
+/* Keep one move of 'moves' (a part of the possible moves of 'board') for
+ * each set of moves that lead to the same position up to a symmetry: the
+ * moves that are images of each other by a symmetry of 'board' itself (the
+ * first one is kept). */
+bitboard_t board_unique_moves (const board_t *board, const bitboard_t moves);
+
+/* Start an iteration on the possible moves of the current player. */
+move_iter_t move_iter_init (const board_t *board);
+
+/* Get the next move of the iteration in the order of the rows and then of the
+ * columns
+ *   -> return false if there is no more move. */
+bool move_iter_next (move_iter_t *iter, move_t *move);
 
 
 /************************ bitboard_t corner management ************************/
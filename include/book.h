@@ -0,0 +1,71 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <board.h>
+
+
+/********************************* Structures *********************************/
+
+/* A move of a position of the opening book and its score. A book file is a
+ * header followed by these entries sorted by key (and by move for a same
+ * key), in the byte order of the machine that wrote it. The symmetric
+ * positions share their entries: the key and the move are the ones of the
+ * canonical form of the position. */
+typedef struct
+{
+    uint64_t key;      /* book_key () of the position. */
+    int16_t score;     /* Score of the move for the player to move. */
+    uint8_t move;      /* row * MAX_BOARD_SIZE + column (canonical). */
+    uint8_t depth;     /* Depth of the search that gave the score. */
+    uint32_t reserved; /* 0. */
+} book_entry_t;
+
+/* Opening book (forward declaration to hide the implementation). */
+typedef struct book_t book_t;
+
+
+/******************************* Opening book *********************************/
+
+/* Key of the position 'board' in a book: the hash of its canonical form.
+ * Store in 'symmetry' (if not NULL) the symmetry from 'board' to this
+ * form. */
+uint64_t book_key (const board_t *board, unsigned *symmetry);
+
+/* Entry of the move 'move' of the position 'board' with its 'score' searched
+ * to 'depth'. */
+book_entry_t book_entry (const board_t *board, const move_t move,
+                         const int score, const size_t depth);
+
+/* Map the book file 'filename' in memory (read-only and shared with the other
+ * processes that map it): nothing is read until a lookup
+ *   -> return the book or NULL if the file can't be mapped or is not a
+ *      book. */
+book_t *book_open (const char *filename);
+
+/* Unmap the book 'book'. */
+void book_close (book_t *book);
+
+/* Get all the entries of 'book' (sorted by key) and their number in
+ * 'count'. */
+const book_entry_t *book_entries (const book_t *book, size_t *count);
+
+/* Find the entries of 'book' of key 'key' and store the first one in
+ * 'entries'
+ *   -> return their number. */
+size_t book_find (const book_t *book, const uint64_t key,
+                  const book_entry_t **entries);
+
+/* Look for the position 'board' in 'book'
+ *   -> return true and store its best move and the score of this move in
+ *      'move' and 'score' if it is found. */
+bool book_lookup (const book_t *book, const board_t *board, move_t *move,
+                  int *score);
+
+/* Sort the 'count' entries 'entries' and write them in the book file
+ * 'filename' (once for each move of a position)
+ *   -> return false if the file can't be written. */
+bool book_write (const char *filename, book_entry_t *entries,
+                 const size_t count);
+
+
+#endif /* BOOK_H */
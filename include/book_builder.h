@@ -0,0 +1,27 @@
+#ifndef BOOK_BUILDER_H
+#define BOOK_BUILDER_H
+
+#include <board.h>
+
+
+/******************************* Book building ********************************/
+
+/* Recover the default number of plies of the opening tree and the depth of
+ * the Newton searches of its leaves for a board of 'size'
+ *   -> return false if 'size' has no book. */
+bool book_defaults (const size_t size, size_t *plies, size_t *depth);
+
+/* Build the opening book of a board of 'size' in the file 'filename': the
+ * opening tree is expanded to 'plies' plies, its leaves are searched by the
+ * Newton AI to 'depth' with 'threads' threads and their values are negamaxed
+ * back to the root. The progress is printed on 'fd'.
+ * If 'filename' is already a book, its entries are kept and its positions
+ * searched at least as deep are not searched again: a deeper tree extends
+ * the book, and a stopped build starts again where its last checkpoint
+ * was written.
+ *   -> return false if the book can't be read or written. */
+bool book_build (const char *filename, const size_t size, const size_t plies,
+                 const size_t depth, const size_t threads, FILE *fd);
+
+
+#endif /* BOOK_BUILDER_H */
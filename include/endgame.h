@@ -0,0 +1,22 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <board.h>
+#include <tt.h>
+
+
+/******************************* Endgame solver *******************************/
+
+/* Search the best move of 'board' by perfect play until the end of the game:
+ * a null window search first tell if the game is won, drawn or lost, then
+ * the exact final score is searched in this range only. The transposition
+ * table 'tt' can be shared with the other searches or NULL. If 'nodes' is
+ * not NULL, the number of positions visited is added to it.
+ *   -> return the best move (MAX_BOARD_SIZE row and column if there is no
+ *      move) and store the final disc difference for the player to move in
+ *      'score'. */
+move_t endgame_best_move (const board_t *board, tt_t *tt, int *score,
+                          size_t *nodes);
+
+
+#endif /* ENDGAME_H */
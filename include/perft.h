@@ -0,0 +1,31 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <board.h>
+
+#include <stdint.h>
+
+
+/****************************** Node counting *********************************/
+
+/* Count the leaves of the game tree of 'board' at 'depth' plies. A pass is
+ * not a ply (the same player plays again as with board_play ()) and a
+ * finished game is a leaf at any depth.
+ *   -> return the number of leaves. */
+uint64_t perft (board_t *board, const size_t depth);
+
+/* Recover the checked-in number of leaves of the start position of a board
+ * of 'size' at 'depth' plies in 'leaves'.
+ *   -> return false if there is no reference for this size and depth. */
+bool perft_reference (const size_t size, const size_t depth, uint64_t *leaves);
+
+/* Count the leaves of 'board' at each depth from 1 to 'depth' with 'threads'
+ * threads and a hash table of the subtree counts of 'megabytes' (0 to count
+ * without it), and print them with the time and the nodes per second on
+ * 'fd'. The counts of a start position are compared to the references.
+ *   -> return false if a count differs from its reference. */
+bool perft_run (board_t *board, const size_t depth, const size_t threads,
+                const size_t megabytes, FILE *fd);
+
+
+#endif /* PERFT_H */
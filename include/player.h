@@ -7,11 +7,59 @@
 #include <board.h>
 
 
+/********************************* Structures *********************************/
+
+/* Number of cutoff counters of the statistics of a search. */
+#define STATS_CUTOFFS 8
+
+/* Statistics of the search of an AI move (summed over all its threads). */
+typedef struct
+{
+    const char *search;    /* "minimax", "alpha/beta", "newton" or "endgame". */
+    size_t depth;          /* Depth reached (empty squares for the solver). */
+    size_t nodes;          /* Positions searched. */
+    size_t evaluations;    /* Leaves valued by the heuristic. */
+    /* Cuts made by the i-th move searched in a node (the last counter keeps
+     * the cuts of all the later moves). */
+    size_t cutoffs[STATS_CUTOFFS];
+    size_t tt_probes;      /* Lookups in the transposition table... */
+    size_t tt_hits;        /* ... and positions found. */
+    double seconds;
+} search_stats_t;
+
+
 /***************************** Intern management ******************************/
 
 /* To activate verbose mode. */
 void set_verbose (void);
 
+/* To set the memory (in megabytes) used by the transposition table of the
+ * alpha / beta AIs, 0 disable it. */
+void set_hash_size (const size_t megabytes);
+
+/* To search the AI moves by iterative deepening in 'seconds' per move instead
+ * of a fixed depth, 0 come back to the fixed depth. */
+void set_time_per_move (const double seconds);
+
+/* To search the root moves of the alpha / beta AIs with 'count' threads. */
+void set_threads (const size_t count);
+
+/* To print the statistics of each AI search as a JSON line. */
+void set_stats (void);
+
+/* Get the statistics of the search of the last AI move (all zero if it was
+ * played without search, as a single possible move). */
+search_stats_t get_search_stats (void);
+
+/* To let the endgame solver play perfectly the alpha / beta AIs moves when
+ * there are at most 'empties' empty squares, 0 disable it. */
+void set_endgame_empties (const size_t empties);
+
+/* To let the alpha / beta AIs play the moves of the opening book file
+ * 'filename' before any search
+ *   -> return false if it can't be opened. */
+bool set_book (const char *filename);
+
 
 /********************************* Heuristics *********************************/
 
@@ -35,5 +83,13 @@ move_t minimax_ab_player (board_t *board);
  * these moves. */
 move_t newton_player (board_t *board);
 
+/* Search 'board' (which must have a move) with the Newton tactic to 'depth',
+ * or with the endgame solver near the end of the game, without the verbose
+ * mode (the time per move must be 0). Each call has its own search, so
+ * several threads can search at once (they share the transposition table)
+ *   -> return the value of the best move for the player to move and store
+ *      this move in 'move'. */
+int newton_value (board_t *board, const size_t depth, move_t *move);
+
 
 #endif /* PLAYER_H */
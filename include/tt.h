@@ -0,0 +1,56 @@
+#ifndef TT_H
+#define TT_H
+
+#include <board.h>
+
+
+/********************************* Structures *********************************/
+
+/* Bound of a score stored in the transposition table. */
+typedef enum
+{
+    TT_EXACT,
+    TT_LOWER, /* The real score is greater or equal. */
+    TT_UPPER, /* The real score is lower or equal. */
+} tt_bound_t;
+
+/* The result of a search stored for a position. */
+typedef struct
+{
+    int score;        /* Score for the player to move. */
+    size_t depth;     /* Depth of the search that found the score. */
+    tt_bound_t bound;
+    move_t move;      /* Best move or MAX_BOARD_SIZE row and column if none. */
+} tt_data_t;
+
+/* Transposition table (forward declaration to hide the implementation). */
+typedef struct tt_t tt_t;
+
+
+/********************** Transposition table management **********************/
+
+/* Allocate a transposition table that use at most 'megabytes' of memory
+ *   -> return pointer to this newly table
+ *      or NULL if something wrong appended. */
+tt_t *tt_alloc (const size_t megabytes);
+
+/* Free the memory allocated to the table 'tt'. */
+void tt_free (tt_t *tt);
+
+/* Remove all the entries of the table 'tt'. */
+void tt_clear (tt_t *tt);
+
+/* Start a new search: the entries of the previous searches are replaced
+ * first. */
+void tt_new_search (tt_t *tt);
+
+/* Look for the position of hash 'hash'
+ *   -> return true and fill 'data' if it is found. */
+bool tt_probe (const tt_t *tt, const uint64_t hash, tt_data_t *data);
+
+/* Store the result 'data' of the search of the position of hash 'hash'. The
+ * table can be probed and stored by several threads at the same time. */
+void tt_store (tt_t *tt, const uint64_t hash, const tt_data_t *data);
+
+
+#endif /* TT_H */
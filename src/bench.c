@@ -0,0 +1,506 @@
+#define _POSIX_C_SOURCE 200809L /* To use clock_gettime (). */
+
+/* The board is compiled in this file so the benchmarks can reach its
+ * internal kernels (the shifts and the engines). */
+#include "board.c"
+#include "reversi.h"
+
+#include <err.h>
+#include <time.h>
+
+#include <player.h>
+
+
+/********************************* Constants **********************************/
+
+/* Number of positions of each board size the kernels are run on. */
+#define POSITIONS 64
+
+/* Number of positions of each board size the Newton AI plays. */
+#define NEWTON_POSITIONS 8
+
+/* Minimal time of a kernel benchmark: its number of operations is doubled
+ * until it runs at least that long. */
+static const double min_seconds = 0.2;
+
+/* Seed of the positions: they are the same at each run so the results of two
+ * builds can be compared. */
+static const uint64_t positions_seed = 0x42656e6368212121ULL;
+
+/* Result of the benchmarks that the compiler can't optimize out. */
+static volatile uint64_t sink;
+
+
+/********************************* Structures *********************************/
+
+/* Positions of a board size and a possible move of each one. */
+typedef struct
+{
+    size_t size;
+    board_t boards[POSITIONS];
+    move_t moves[POSITIONS];
+} position_set_t;
+
+/* A benchmark of a kernel: run it 'ops' times on the positions of 'set'
+ *   -> return a checksum of the results. */
+typedef uint64_t (*kernel_bench_t) (const position_set_t *set,
+                                    const uint64_t ops);
+
+
+/******************************* Internal tools *******************************/
+
+/* Seconds elapsed since 'start'. */
+static double
+elapsed (const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) +
+           (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* A random move of 'board' (which must have one). */
+static move_t
+random_move (const board_t *board, uint64_t *state)
+{
+    size_t count = board_count_player_moves (board);
+    size_t chosen = splitmix64 (state) % count;
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
+    for (size_t i = 0; i <= chosen; i++)
+    {
+        move_iter_next (&iter, &move);
+    }
+
+    return move;
+}
+
+/* Play random moves from the start position of 'size' until a position where
+ * the player to move has at least 'min_moves' moves, after 'plies' moves at
+ * most
+ *   -> return NULL if the allocation failed. */
+static board_t *
+random_position (const size_t size, const size_t plies,
+                 const size_t min_moves, uint64_t *state)
+{
+    board_t *board = board_init (size);
+
+    while (board != NULL)
+    {
+        for (size_t i = 0; i < plies && board_player (board) != EMPTY_DISC;
+             i++)
+        {
+            board_play (board, random_move (board, state));
+        }
+
+        if (board_count_player_moves (board) >= min_moves)
+        {
+            return board;
+        }
+
+        /* Finished game: start again. */
+        board_free (board);
+        board = board_init (size);
+    }
+
+    return NULL;
+}
+
+/* Fill 'set' with positions of 'size' from the opening to the endgame
+ *   -> return false if an allocation failed. */
+static bool
+position_set_init (position_set_t *set, const size_t size, uint64_t *state)
+{
+    set->size = size;
+
+    for (size_t i = 0; i < POSITIONS; i++)
+    {
+        size_t plies = splitmix64 (state) % (size * size - 4);
+        board_t *board = random_position (size, plies, 1, state);
+
+        if (board == NULL)
+        {
+            return false;
+        }
+
+        set->boards[i] = *board;
+        set->moves[i] = random_move (board, state);
+        board_free (board);
+    }
+
+    return true;
+}
+
+/* Print the result of a benchmark of 'ops' operations that visited 'nodes'
+ * nodes in 'seconds' as a JSON object ('first' tell if it is the first one of
+ * the list). */
+static void
+print_result (const char *name, const size_t size, const uint64_t ops,
+              const uint64_t nodes, const double seconds, const bool first)
+{
+    printf ("%s\n    {\"name\": \"%s\", \"size\": %zu, \"ops\": %llu, "
+            "\"seconds\": %.6f, \"ns_per_op\": %.3f, \"nodes_per_s\": %.0f}",
+            first ? "" : ",", name, size, (unsigned long long) ops, seconds,
+            seconds * 1e9 / ops, nodes / seconds);
+}
+
+/* Run the kernel benchmark 'bench' on 'set' long enough to be measured and
+ * print its result. */
+static void
+measure (const char *name, kernel_bench_t bench, const position_set_t *set,
+         const bool first)
+{
+    uint64_t ops = 1024;
+    double seconds;
+
+    for (;;)
+    {
+        struct timespec start;
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        sink += bench (set, ops);
+        seconds = elapsed (&start);
+
+        if (seconds >= min_seconds)
+        {
+            break;
+        }
+
+        ops *= 2;
+    }
+
+    /* A call of a kernel is a node of a search. */
+    print_result (name, set->size, ops, ops, seconds, first);
+}
+
+
+/****************************** Kernel benchmarks *****************************/
+
+/* The moves of the player to move, through the engine of the board size. */
+static uint64_t
+bench_compute_moves (const position_set_t *set, const uint64_t ops)
+{
+    const engine_t *engine = engine_for_size (set->size);
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+        checksum += (uint64_t) engine->compute_moves (set->size, board->black,
+                                                      board->white);
+    }
+
+    return checksum;
+}
+
+/* A move played on a copy of a position (the copy is in the time). */
+static uint64_t
+bench_board_play (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        board_t board = set->boards[i % POSITIONS];
+        board_play (&board, set->moves[i % POSITIONS]);
+        checksum += board.hash;
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_popcount (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+        checksum += bitboard_popcount (board->black | board->white);
+    }
+
+    return checksum;
+}
+
+/* The shifts of the engine of the board size, in the 8 directions in turn. */
+static uint64_t
+bench_shift_by (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            int offset = shifts_64[set->size].offsets[i % 8];
+            checksum += shift_by_64 ((uint64_t) board->black, offset);
+        }
+        else
+        {
+            int offset = shifts_128[set->size].offsets[i % 8];
+            checksum += (uint64_t) shift_by_128 (board->black, offset);
+        }
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_shift (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            checksum += shift_64 (&shifts_64[set->size],
+                                  (uint64_t) board->black, i % 8);
+        }
+        else
+        {
+            checksum += (uint64_t) shift_128 (&shifts_128[set->size],
+                                              board->black, i % 8);
+        }
+    }
+
+    return checksum;
+}
+
+/* The symmetry kernels of the engine of the board size. */
+static uint64_t
+bench_flip_vertical (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            checksum += flip_vertical_64 (set->size, (uint64_t) board->black);
+        }
+        else
+        {
+            checksum += (uint64_t) flip_vertical_128 (set->size, board->black);
+        }
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_flip_horizontal (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            checksum += flip_horizontal_64 (set->size,
+                                            (uint64_t) board->black);
+        }
+        else
+        {
+            checksum += (uint64_t) flip_horizontal_128 (set->size,
+                                                        board->black);
+        }
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_flip_diagonal (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            checksum += flip_diagonal_64 (set->size, (uint64_t) board->black);
+        }
+        else
+        {
+            checksum += (uint64_t) flip_diagonal_128 (set->size, board->black);
+        }
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_rotate (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+
+        if (set->size * set->size <= 64)
+        {
+            checksum += rotate_64 (set->size, (uint64_t) board->black);
+        }
+        else
+        {
+            checksum += (uint64_t) rotate_128 (set->size, board->black);
+        }
+    }
+
+    return checksum;
+}
+
+/* The 8 images of a position and its canonical hash. */
+static uint64_t
+bench_canonical_hash (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        checksum += board_canonical_hash (&set->boards[i % POSITIONS], NULL);
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_corners_to_exam (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+        checksum += (uint64_t) get_corners_to_exam (board);
+    }
+
+    return checksum;
+}
+
+static uint64_t
+bench_interesting_borders (const position_set_t *set, const uint64_t ops)
+{
+    uint64_t checksum = 0;
+
+    for (uint64_t i = 0; i < ops; i++)
+    {
+        const board_t *board = &set->boards[i % POSITIONS];
+        checksum += (uint64_t) get_interesting_borders (board);
+    }
+
+    return checksum;
+}
+
+
+/******************************* Newton benchmark *****************************/
+
+/* Play a move of the Newton AI on each of NEWTON_POSITIONS positions of
+ * 'size' (a search is an operation) and print the result
+ *   -> return false if an allocation failed. */
+static bool
+bench_newton (const size_t size, uint64_t *state)
+{
+    double seconds = 0;
+    uint64_t nodes = 0;
+
+    for (size_t i = 0; i < NEWTON_POSITIONS; i++)
+    {
+        /* From the opening to the middle of the game. */
+        size_t plies = i * (size * size - 4) / (2 * NEWTON_POSITIONS);
+        board_t *board = random_position (size, plies, 2, state);
+
+        if (board == NULL)
+        {
+            return false;
+        }
+
+        struct timespec start;
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        move_t move = newton_player (board);
+        seconds += elapsed (&start);
+        nodes += get_search_stats ().nodes;
+        sink += move.row * size + move.column;
+        board_free (board);
+    }
+
+    print_result ("newton_player", size, NEWTON_POSITIONS, nodes, seconds,
+                  false);
+
+    return true;
+}
+
+
+/************************************ Main ************************************/
+
+/* Run all the benchmarks on every board size with a game (the 2x2 board has
+ * no move) and print their results as JSON. */
+int
+main (void)
+{
+    static const struct
+    {
+        const char *name;
+        kernel_bench_t bench;
+    } kernels[] =
+    {
+        {"compute_moves", bench_compute_moves},
+        {"board_play", bench_board_play},
+        {"bitboard_popcount", bench_popcount},
+        {"shift_by", bench_shift_by},
+        {"shift", bench_shift},
+        {"flip_vertical", bench_flip_vertical},
+        {"flip_horizontal", bench_flip_horizontal},
+        {"flip_diagonal", bench_flip_diagonal},
+        {"rotate", bench_rotate},
+        {"board_canonical_hash", bench_canonical_hash},
+        {"get_corners_to_exam", bench_corners_to_exam},
+        {"get_interesting_borders", bench_interesting_borders}
+    };
+
+    static position_set_t set;
+    uint64_t state = positions_seed;
+    bool first = true;
+
+    printf ("{\n  \"version\": \"%d.%d.%d\",\n  \"benchmarks\": [",
+            VERSION, SUBVERSION, REVISION);
+
+    for (size_t size = 4; size <= MAX_BOARD_SIZE; size += 2)
+    {
+        if (!position_set_init (&set, size, &state))
+        {
+            errx (EXIT_FAILURE, "Impossible to build the positions.\n");
+        }
+
+        for (size_t k = 0; k < sizeof (kernels) / sizeof (kernels[0]); k++)
+        {
+            measure (kernels[k].name, kernels[k].bench, &set, first);
+            first = false;
+        }
+
+        if (!bench_newton (size, &state))
+        {
+            errx (EXIT_FAILURE, "Impossible to build the positions.\n");
+        }
+
+        fflush (stdout);
+    }
+
+    printf ("\n  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
@@ -1,10 +1,23 @@
 #include <board.h>
 
+#include <stdint.h>
 #include <string.h>
 
 
 /********************************* Structure **********************************/
 
+/* Bitboard kernels of a board engine, specialized for a bitboard width. */
+typedef struct
+{
+    bitboard_t (*compute_moves) (const size_t, const bitboard_t,
+                                 const bitboard_t);
+    bitboard_t (*compute_flips) (const size_t, const bitboard_t,
+                                 const bitboard_t, const bitboard_t);
+    size_t (*popcount) (const bitboard_t);
+    size_t (*pop_first_bit) (bitboard_t *);
+    bitboard_t (*symmetry) (const size_t, const bitboard_t, const unsigned);
+} engine_t;
+
 /* Internal board_t structure (hiden from the outsid) */
 struct board_t
 {
@@ -13,173 +26,235 @@ struct board_t
     bitboard_t black;
     bitboard_t white;
     bitboard_t moves;
-    bitboard_t next_move;
+    uint64_t hash;
+    const engine_t *engine;
 };
 
 
-/*************************** Function declarations ****************************/
-
-/* --------------------------------- Shifts --------------------------------- */
-
-static bitboard_t shift_north (const size_t, const bitboard_t);
-static bitboard_t shift_ne (const size_t, const bitboard_t);
-static bitboard_t shift_east (const size_t, const bitboard_t);
-static bitboard_t shift_se (const size_t, const bitboard_t);
-static bitboard_t shift_south (const size_t, const bitboard_t);
-static bitboard_t shift_sw (const size_t, const bitboard_t);
-static bitboard_t shift_west (const size_t, const bitboard_t);
-static bitboard_t shift_nw (const size_t, const bitboard_t);
-
-/* ---------------------------- Moves management ---------------------------- */
-
-static bitboard_t compute_moves (const size_t size, const bitboard_t player,
-                                 const bitboard_t opponent);
-
-
 /********************************* Constants **********************************/
 
 /* Arrays used for board_print. */
 static const char columns[] = "A B C D E F G H I J";
 static const size_t rows[] = {1,2,3,4,5,6,7,8,9,10};
 
-/* Array of function pointer on directions. */
-static bitboard_t (*shifts[DIRECTIONS]) (const size_t, const bitboard_t) =
-{shift_north, shift_ne, shift_east, shift_se,
- shift_south, shift_sw, shift_west, shift_nw};
-
 /* Movement to do in the row in function of the direction. */
 static int row_direction[DIRECTIONS] = {1, 1, 0, -1, -1, -1, 0, 1};
 
 /* Movement to do in the column in function of the direction. */
 static int column_direction[DIRECTIONS] = {0, -1, -1, -1, 0, 1, 1, 1};
 
-
-/*************************** bitboard_t management ****************************/
-
-size_t
-bitboard_popcount (const bitboard_t bitboard)
+/* Zobrist keys of a black disc, of a white disc and of the reversal of a disc
+ * on each square, of the white player to move and of each board size
+ * (filled once at startup by zobrist_init ()). */
+static uint64_t zobrist_black[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+static uint64_t zobrist_white[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+static uint64_t zobrist_flip[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+static uint64_t zobrist_white_player;
+static uint64_t zobrist_size[MAX_BOARD_SIZE + 1];
+
+
+/********************************** Engines ***********************************/
+
+/* Engine on 64 bits, for the boards up to 8x8. */
+#define KERNEL_T uint64_t
+#define KERNEL(name) name ## _64
+#include "board_kernels.h"
+#undef KERNEL
+#undef KERNEL_T
+
+/* Engine on 128 bits, for the 10x10 board. */
+#define KERNEL_T bitboard_t
+#define KERNEL(name) name ## _128
+#include "board_kernels.h"
+#undef KERNEL
+#undef KERNEL_T
+
+/* The engines start with the portable kernels, engines_init () switch them
+ * to the hardware ones if the CPU can run them. */
+static engine_t engine_64 =
+{compute_moves_64, compute_flips_64, popcount_64, pop_first_bit_64,
+ symmetry_64};
+
+static engine_t engine_128 =
+{compute_moves_128, compute_flips_128, popcount_128, pop_first_bit_128,
+ symmetry_128};
+
+/* Build the tables of the engines and select their kernels for this CPU once,
+ * before main () is called. */
+static void __attribute__ ((constructor))
+engines_init (void)
 {
-    bitboard_t only_3 = 0x3333333333333333;
-    bitboard_t only_5 = 0x5555555555555555;
-    bitboard_t only_0F = 0x0F0F0F0F0F0F0F0F;
-    bitboard_t only_01 = 0x0101010101010101;
-    bitboard_t copy1 = bitboard;
-    bitboard_t copy2 = bitboard >> 64;
-
-    copy1 -= ((copy1 >> 1) & only_5);
-    copy1 = (copy1 & only_3) + ((copy1 >> 2) & only_3);
-    copy1 = (copy1 + (copy1 >> 4)) & only_0F;
-
-    copy2 -= ((copy2 >> 1) & only_5);
-    copy2 = (copy2 & only_3) + ((copy2 >> 2) & only_3);
-    copy2 = (copy2 + (copy2 >> 4)) & only_0F;
-
-    return (((copy1 * only_01) >> 56) & 0x7F) +
-           (((copy2 * only_01) >> 56) & 0x7F);
-}
+    init_shifts_64 ();
+    init_shifts_128 ();
+    init_symmetries_64 ();
+    init_symmetries_128 ();
 
-/* --------------------------------- Shifts --------------------------------- */
+#if defined (__x86_64__)
+    __builtin_cpu_init ();
 
-static bitboard_t
-shift_north (const size_t size, const bitboard_t bitboard)
-{
-    if (!board_cheak_size (size))
+    if (__builtin_cpu_supports ("popcnt"))
     {
-        return (bitboard_t) 0;
+        engine_64.popcount = popcount_hw_64;
+        engine_128.popcount = popcount_hw_128;
     }
 
-    bitboard_t ones = ((bitboard_t) 1 << (size * (size - 1))) - 1;
-    ones = ones << size;
-    bitboard_t first_row = bitboard & (~ones);
-    bitboard_t bitboard2 = bitboard & ones;
-
-    return ((bitboard2 >> size) | (first_row << ((size - 1) * size)));
+    if (__builtin_cpu_supports ("bmi"))
+    {
+        engine_64.pop_first_bit = pop_first_bit_hw_64;
+        engine_128.pop_first_bit = pop_first_bit_hw_128;
+    }
+#endif
 }
 
-static bitboard_t
-shift_south (const size_t size, const bitboard_t bitboard)
+/* Choose the engine of a board of size 'size' (once for the whole game). */
+static const engine_t*
+engine_for_size (const size_t size)
 {
-    if (!board_cheak_size (size))
-    {
-        return (bitboard_t) 0;
-    }
+    return (size * size <= 64) ? &engine_64 : &engine_128;
+}
+
 
-    bitboard_t ones = ((bitboard_t) 1 << (size * (size - 1))) - 1;
-    bitboard_t first_row = bitboard & (~ones);
-    bitboard_t bitboard2 = bitboard & ones;
+/****************************** Zobrist hashing *******************************/
 
-    return ((bitboard2 << size) | (first_row >> ((size - 1) * size)));
+/* SplitMix64 pseudo-random generator: the keys are the same at each run so
+ * the hashes can be stored in files. */
+static uint64_t
+splitmix64 (uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
 }
 
-static bitboard_t
-shift_east (const size_t size, const bitboard_t bitboard)
+/* Fill the Zobrist keys once, before main () is called. */
+static void __attribute__ ((constructor))
+zobrist_init (void)
 {
-    if (!board_cheak_size (size))
+    uint64_t state = 0x5265766572736921ULL;
+
+    for (size_t i = 0; i < MAX_BOARD_SIZE * MAX_BOARD_SIZE; i++)
     {
-        return (bitboard_t) 0;
+        zobrist_black[i] = splitmix64 (&state);
+        zobrist_white[i] = splitmix64 (&state);
+        zobrist_flip[i] = zobrist_black[i] ^ zobrist_white[i];
     }
 
-    bitboard_t ones = ((bitboard_t) 1 << (size - 1)) - 1;
+    zobrist_white_player = splitmix64 (&state);
 
-    for (size_t i = 0; i < (size - 1); i++)
+    for (size_t i = 0; i <= MAX_BOARD_SIZE; i++)
     {
-        ones |= (ones << size);
+        zobrist_size[i] = splitmix64 (&state);
     }
+}
 
-    bitboard_t last_column = bitboard & (~ones);
-    bitboard_t bitboard2 = bitboard & ones;
-    bitboard2 = bitboard2 << 1;
-    last_column = last_column >> (size - 1);
-
-    return (bitboard2 | last_column);
+/* Zobrist key of the player to move. */
+static uint64_t
+zobrist_player (const disc_t player)
+{
+    return (player == WHITE_DISC) ? zobrist_white_player : 0;
 }
 
-static bitboard_t
-shift_west (const size_t size, const bitboard_t bitboard)
+/* Xor of the keys 'keys' of all the squares of the bitboard. */
+static uint64_t
+zobrist_squares (const engine_t *engine, const uint64_t keys[],
+                 bitboard_t bitboard)
 {
-    if (!board_cheak_size (size))
+    uint64_t hash = 0;
+
+    while (bitboard != 0)
     {
-        return (bitboard_t) 0;
+        hash ^= keys[engine->pop_first_bit (&bitboard)];
     }
 
-    bitboard_t ones = ((bitboard_t) 1 << (size - 1)) - 1;
-    ones = ones << 1;
+    return hash;
+}
+
+/* Compute the hash of the board from scratch. */
+static uint64_t
+zobrist_board (const board_t *board)
+{
+    return zobrist_size[board->size] ^ zobrist_player (board->player) ^
+           zobrist_squares (board->engine, zobrist_black, board->black) ^
+           zobrist_squares (board->engine, zobrist_white, board->white);
+}
 
-    for (size_t i = 0; i < (size - 1); i++)
-    {
-        ones |= (ones << size);
-    }
 
-    bitboard_t last_column = bitboard & (~ones);
-    bitboard_t bitboard2 = bitboard & ones;
-    bitboard2 = bitboard2 >> 1;
-    last_column = last_column << (size - 1);
+/*************************** bitboard_t management ****************************/
 
-    return (bitboard2 | last_column);
+size_t
+bitboard_popcount (const bitboard_t bitboard)
+{
+    return engine_128.popcount (bitboard);
 }
 
-static bitboard_t
-shift_nw (const size_t size, const bitboard_t bitboard)
+size_t
+bitboard_pop_first_bit (bitboard_t *bitboard)
 {
-    return shift_north (size, shift_west (size, bitboard));
+    return engine_128.pop_first_bit (bitboard);
 }
 
-static bitboard_t
-shift_sw (const size_t size, const bitboard_t bitboard)
+bitboard_t
+bitboard_moves (const size_t size, const bitboard_t player,
+                const bitboard_t opponent)
 {
-    return shift_south (size, shift_west (size, bitboard));
+    return engine_for_size (size)->compute_moves (size, player, opponent);
 }
 
-static bitboard_t
-shift_se (const size_t size, const bitboard_t bitboard)
+bitboard_t
+bitboard_flips (const size_t size, const bitboard_t player,
+                const bitboard_t opponent, const bitboard_t bit)
 {
-    return shift_south (size, shift_east (size, bitboard));
+    return engine_for_size (size)->compute_flips (size, player, opponent, bit);
 }
 
-static bitboard_t
-shift_ne (const size_t size, const bitboard_t bitboard)
+bitboard_t
+bitboard_symmetry (const size_t size, const bitboard_t bitboard,
+                   const unsigned symmetry)
+{
+    return engine_for_size (size)->symmetry (size, bitboard, symmetry);
+}
+
+unsigned
+symmetry_inverse (const unsigned symmetry)
 {
-    return shift_north (size, shift_east (size, bitboard));
+    /* A flip of the rows after the diagonal one is a flip of the columns
+     * before it (and conversely). */
+    if (symmetry & SYMMETRY_FLIP_DIAGONAL)
+    {
+        return SYMMETRY_FLIP_DIAGONAL |
+               ((symmetry & SYMMETRY_FLIP_VERTICAL) ?
+                SYMMETRY_FLIP_HORIZONTAL : 0) |
+               ((symmetry & SYMMETRY_FLIP_HORIZONTAL) ?
+                SYMMETRY_FLIP_VERTICAL : 0);
+    }
+
+    return symmetry;
+}
+
+move_t
+move_symmetry (const size_t size, const move_t move, const unsigned symmetry)
+{
+    move_t image = move;
+
+    if (symmetry & SYMMETRY_FLIP_DIAGONAL)
+    {
+        image.row = move.column;
+        image.column = move.row;
+    }
+
+    if (symmetry & SYMMETRY_FLIP_VERTICAL)
+    {
+        image.row = size - 1 - image.row;
+    }
+
+    if (symmetry & SYMMETRY_FLIP_HORIZONTAL)
+    {
+        image.column = size - 1 - image.column;
+    }
+
+    return image;
 }
 
 /* --------------------------- General management --------------------------- */
@@ -230,6 +305,69 @@ board_player (const board_t *board)
     return board->player;
 }
 
+uint64_t
+board_hash (const board_t *board)
+{
+    if (board == NULL)
+    {
+        return 0;
+    }
+
+    return board->hash;
+}
+
+uint64_t
+board_canonical_hash (const board_t *board, unsigned *symmetry)
+{
+    if (board == NULL)
+    {
+        return 0;
+    }
+
+    const engine_t *engine = board->engine;
+    bitboard_t black = board->black;
+    bitboard_t white = board->white;
+    unsigned best = 0;
+
+    /* The canonical form has the smallest black discs, then the smallest
+     * white discs. */
+    for (unsigned s = 1; s < SYMMETRIES; s++)
+    {
+        bitboard_t image_black = engine->symmetry (board->size, board->black,
+                                                   s);
+
+        if (image_black > black)
+        {
+            continue;
+        }
+
+        bitboard_t image_white = engine->symmetry (board->size, board->white,
+                                                   s);
+
+        if (image_black < black || image_white < white)
+        {
+            black = image_black;
+            white = image_white;
+            best = s;
+        }
+    }
+
+    if (symmetry != NULL)
+    {
+        *symmetry = best;
+    }
+
+    /* The hash of the board itself is up to date. */
+    if (best == 0)
+    {
+        return board->hash;
+    }
+
+    return zobrist_size[board->size] ^ zobrist_player (board->player) ^
+           zobrist_squares (engine, zobrist_black, black) ^
+           zobrist_squares (engine, zobrist_white, white);
+}
+
 void
 board_set_player (board_t *board, disc_t player)
 {
@@ -238,15 +376,18 @@ board_set_player (board_t *board, disc_t player)
         return;
     }
 
+    board->hash ^= zobrist_player (board->player) ^ zobrist_player (player);
     board->player = player;
 
     if (board->player == BLACK_DISC)
     {
-        board->moves = compute_moves (board->size, board->black, board->white);
+        board->moves = board->engine->compute_moves (board->size, board->black,
+                                                     board->white);
     }
     else if (board->player == WHITE_DISC)
     {
-        board->moves = compute_moves (board->size, board->white, board->black);
+        board->moves = board->engine->compute_moves (board->size, board->white,
+                                                     board->black);
     }
 }
 
@@ -278,6 +419,27 @@ board_get (const board_t *board, const size_t row, const size_t column)
     }
 }
 
+bitboard_t
+board_discs (const board_t *board, const disc_t disc)
+{
+    if (board == NULL)
+    {
+        return (bitboard_t) 0;
+    }
+
+    switch (disc)
+    {
+        case BLACK_DISC :
+            return board->black;
+
+        case WHITE_DISC :
+            return board->white;
+
+        default :
+            return (bitboard_t) 0;
+    }
+}
+
 void
 board_set (board_t *board, const disc_t disc, const size_t row,
            const size_t column)
@@ -288,6 +450,11 @@ board_set (board_t *board, const disc_t disc, const size_t row,
     }
 
     bitboard_t bit = set_bitboard (board->size, row, column);
+    /* Remove the key of the previous disc of the square. */
+    board->hash ^= zobrist_squares (board->engine, zobrist_black,
+                                    board->black & bit) ^
+                   zobrist_squares (board->engine, zobrist_white,
+                                    board->white & bit);
 
     switch (disc)
     {
@@ -313,6 +480,12 @@ board_set (board_t *board, const disc_t disc, const size_t row,
             break;
     }
 
+    /* Add the key of the new disc of the square. */
+    board->hash ^= zobrist_squares (board->engine, zobrist_black,
+                                    board->black & bit) ^
+                   zobrist_squares (board->engine, zobrist_white,
+                                    board->white & bit);
+
     if (board->player == EMPTY_DISC)
     {
         return;
@@ -321,11 +494,13 @@ board_set (board_t *board, const disc_t disc, const size_t row,
     /* Adapt the new possibility to move * with compute_moves (). */
     if (board->player == BLACK_DISC)
     {
-        board->moves = compute_moves (board->size, board->black, board->white);
+        board->moves = board->engine->compute_moves (board->size, board->black,
+                                                     board->white);
     }
     else
     {
-        board->moves = compute_moves (board->size, board->white, board->black);
+        board->moves = board->engine->compute_moves (board->size, board->white,
+                                                     board->black);
     }
 }
 
@@ -337,8 +512,8 @@ board_score (const board_t *board)
         return (score_t) {.white = 0, .black = 0};
     }
 
-    return (score_t) {.white = bitboard_popcount (board->white),
-                      .black = bitboard_popcount (board->black)};
+    return (score_t) {.white = board->engine->popcount (board->white),
+                      .black = board->engine->popcount (board->black)};
 }
 
 int
@@ -407,7 +582,8 @@ board_alloc (const size_t size, const disc_t player)
     game_board->black = 0;
     game_board->white = 0;
     game_board->moves = 0;
-    game_board->next_move = 0;
+    game_board->engine = engine_for_size (size);
+    game_board->hash = zobrist_board (game_board);
 
     return game_board;
 }
@@ -437,8 +613,10 @@ board_init (const size_t size)
     game_board->white |= set_bitboard (size, size / 2, size / 2);
     game_board->black = set_bitboard (size, size / 2 - 1, size / 2);
     game_board->black |= set_bitboard (size, size / 2, size / 2 - 1);
-    game_board->moves = compute_moves (size, game_board->black,
-                                       game_board->white);
+    game_board->moves = game_board->engine->compute_moves (size,
+                                                           game_board->black,
+                                                           game_board->white);
+    game_board->hash = zobrist_board (game_board);
 
     if (size == 2) /* the game is already finished. */
     {
@@ -466,76 +644,13 @@ board_copy (const board_t *board)
     game_board->black = board->black;
     game_board->white = board->white;
     game_board->moves = board->moves;
-    game_board->next_move = board->next_move;
+    game_board->hash = board->hash;
 
     return game_board;
 }
 
 /* ---------------------------- Moves management ---------------------------- */
 
-/* Find the distance between two no-opponents to know the size associate. */
-static size_t
-board_distance_between_no_opponents (const size_t size,
-                                     const bitboard_t opponent,
-                                     const move_t move, const size_t direction)
-{
-    bitboard_t adversary = opponent;
-    bitboard_t bit = set_bitboard (size, move.row, move.column);
-    size_t gap = 0;
-
-    do
-    {
-        adversary = shifts[direction] (size, adversary);
-        gap++;
-    } while ((adversary & bit) != 0);
-
-    return gap;
-}
-
-/* Compute all the possible moves as HINT_DISC (*) for the current player.  */
-static bitboard_t
-compute_moves (const size_t size, const bitboard_t player,
-                                  const bitboard_t opponent)
-{
-    bitboard_t possible_moves = 0;
-
-    for (size_t row = 0; row < size; row++)
-    {
-        for (size_t col = 0; col < size; col++)
-        {
-            if ((player & set_bitboard (size, row, col)) == 0)
-            {
-                continue;
-            }
-
-            for (size_t d = 0; d < DIRECTIONS; d++)
-            {
-                move_t move = (move_t) {.row = row, .column = col};
-                size_t gap = board_distance_between_no_opponents (size,
-                                                                  opponent,
-                                                                  move, d);
-                int i = row + row_direction[d] * gap;
-                int j = col + column_direction[d] * gap;
-
-                if (gap <= 1 || i < 0 || ((size_t) i) >= size ||
-                    j < 0 || ((size_t) j) >= size)
-                {
-                    continue;
-                }
-
-                bitboard_t bit = set_bitboard (size, (size_t) i, (size_t) j);
-
-                if ((player & bit) == 0)
-                {
-                    possible_moves |= bit;
-                }
-            }
-        }
-    }
-
-    return possible_moves;
-}
-
 size_t
 board_count_player_moves (const board_t *board)
 {
@@ -545,7 +660,7 @@ board_count_player_moves (const board_t *board)
         return 0;
     }
 
-    return bitboard_popcount (board->moves);
+    return board->engine->popcount (board->moves);
 }
 
 bool
@@ -561,54 +676,29 @@ board_is_move_valid (const board_t *board, const move_t move)
              board->moves) != (bitboard_t) 0);
 }
 
-/* Reverse all the opponent between two player disc. */
-static void
-board_reverse_opponents (board_t *board, const move_t move)
+bool
+board_do_move (board_t *board, const move_t move, undo_t *undo)
 {
-    bitboard_t adversary = (board_player (board) == BLACK_DISC) ?
-                           board->white : board->black;
-    bitboard_t player = (board_player (board) == WHITE_DISC) ?
-                        board->white : board->black;
-
-    for (size_t d = 0; d < DIRECTIONS; d++)
+    if (undo == NULL)
     {
-        size_t gap = board_distance_between_no_opponents (board_size (board),
-                                                          adversary, move, d);
-        int i = move.row + row_direction[d] * gap;
-        int j = move.column + column_direction[d] * gap;
-
-        if (gap <= 1 || i < 0 || ((size_t) i) >= board->size ||
-            j < 0 || ((size_t) j) >= board->size ||
-            (player & set_bitboard (board->size, (size_t) i, (size_t) j)) == 0)
-        {
-            continue;
-        }
-
-        for (size_t t = 1; t < gap; t++)
-        {
-            board_set (board, board_player (board),
-                       move.row + t * row_direction[d],
-                       move.column + t * column_direction[d]);
-        }
+        return false;
     }
-}
 
-bool
-board_play (board_t *board, const move_t move)
-{
     if (board != NULL && board->moves == 0)
     {
         switch (board->player)
         {
             case WHITE_DISC :
-                board->moves = compute_moves (board->size, board->white,
-                                              board->black);
+                board->moves = board->engine->compute_moves (board->size,
+                                                             board->white,
+                                                             board->black);
 
                 break;
 
             case BLACK_DISC :
-                board->moves = compute_moves (board->size, board->black,
-                                              board->white);
+                board->moves = board->engine->compute_moves (board->size,
+                                                             board->black,
+                                                             board->white);
 
                 break;
 
@@ -622,27 +712,26 @@ board_play (board_t *board, const move_t move)
         return false;
     }
 
+    bitboard_t *player;
+    bitboard_t *opponent;
+    const uint64_t *player_keys;
+    disc_t next_player;
+
     switch (board->player) /* Possible move. */
     {
         case WHITE_DISC :
-            /* Place the player at the chosen position. */
-            board->white |= set_bitboard (board->size, move.row, move.column);
-            /* Reverse all opposents between 2 players discs. */
-            board_reverse_opponents (board, move);
-            /* Pass the hand to the opponent. */
-            board_set_player (board, BLACK_DISC);
-            /* Calculate news possible moves for opponent. */
-            board->moves = compute_moves (board->size, board->black,
-                                          board->white);
+            player = &board->white;
+            opponent = &board->black;
+            player_keys = zobrist_white;
+            next_player = BLACK_DISC;
 
             break;
 
         case BLACK_DISC :
-            board->black |= set_bitboard (board->size, move.row, move.column);
-            board_reverse_opponents (board, move);
-            board_set_player (board, WHITE_DISC);
-            board->moves = compute_moves (board->size, board->white,
-                                          board->black);
+            player = &board->black;
+            opponent = &board->white;
+            player_keys = zobrist_black;
+            next_player = WHITE_DISC;
 
             break;
 
@@ -650,75 +739,156 @@ board_play (board_t *board, const move_t move)
             return false;
     }
 
-    /* If no possible move for the current player. */
-    if (board_count_player_moves (board) == 0)
-    {
-        switch (board->player)
-        {
-            case WHITE_DISC :
-                /* Set the hand to opponent. */
-                board_set_player (board, BLACK_DISC);
-                /* Calculate news possible moves for opponent. */
-                board->moves = compute_moves (board->size, board->black,
-                                              board->white);
+    /* Place the player at the chosen position and reverse all opponents
+     * between 2 players discs. */
+    bitboard_t bit = set_bitboard (board->size, move.row, move.column);
+    bitboard_t flips = board->engine->compute_flips (board->size, *player,
+                                                     *opponent, bit);
+    *player ^= flips | bit;
+    *opponent ^= flips;
 
-                break;
+    undo->square = bit;
+    undo->flips = flips;
+    undo->moves = board->moves;
+    undo->hash = board->hash;
+    undo->player = board->player;
 
-            case BLACK_DISC :
-                board_set_player (board, WHITE_DISC);
-                board->moves = compute_moves (board->size, board->white,
-                                              board->black);
+    /* The player to move is added back at the end of the move. */
+    board->hash ^= zobrist_player (board->player) ^
+                   player_keys[move.row * board->size + move.column] ^
+                   zobrist_squares (board->engine, zobrist_flip, flips);
 
-                break;
+    /* Pass the hand to the opponent and calculate its possible moves. */
+    board->moves = board->engine->compute_moves (board->size, *opponent,
+                                                 *player);
+    board->player = next_player;
 
-            default :
-                return false;
-        }
+    /* If no possible move for the opponent, the hand come back. */
+    if (board->moves == 0)
+    {
+        board->moves = board->engine->compute_moves (board->size, *player,
+                                                     *opponent);
+        board->player = (next_player == BLACK_DISC) ? WHITE_DISC : BLACK_DISC;
     }
 
-    /* If opponent can't move too => end of game. */
-    if (board_count_player_moves (board) == 0)
+    /* If player can't move too => end of game. */
+    if (board->moves == 0)
     {
-        board_set_player (board, EMPTY_DISC);
+        board->player = EMPTY_DISC;
     }
 
+    board->hash ^= zobrist_player (board->player);
+
     return true;
 }
 
-move_t
-board_next_move (board_t *board)
+bool
+board_play (board_t *board, const move_t move)
 {
-    move_t next_move = (move_t)
-                       {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
+    undo_t undo;
 
-    if (board == NULL || board->moves == 0)
+    return board_do_move (board, move, &undo);
+}
+
+void
+board_undo_move (board_t *board, const undo_t *undo)
+{
+    if (board == NULL || undo == NULL)
     {
-        return next_move;
+        return;
     }
 
-    if (board->next_move == 0)
+    bitboard_t *player = (undo->player == BLACK_DISC) ? &board->black :
+                                                        &board->white;
+    bitboard_t *opponent = (undo->player == BLACK_DISC) ? &board->white :
+                                                          &board->black;
+    *player ^= undo->flips | undo->square;
+    *opponent ^= undo->flips;
+    board->player = undo->player;
+    board->moves = undo->moves;
+    board->hash = undo->hash;
+}
+
+bitboard_t
+board_moves (const board_t *board)
+{
+    if (board == NULL ||
+        ((board->player != WHITE_DISC) && (board->player != BLACK_DISC)))
     {
-        board->next_move = board->moves;
+        return (bitboard_t) 0;
     }
 
-    for (size_t i = 0; i < board->size; i++)
+    return board->moves;
+}
+
+bitboard_t
+board_unique_moves (const board_t *board, const bitboard_t moves)
+{
+    if (board == NULL)
     {
-        for (size_t j = 0; j < board->size; j++)
+        return (bitboard_t) 0;
+    }
+
+    const engine_t *engine = board->engine;
+    unsigned symmetries[SYMMETRIES];
+    size_t count = 0;
+
+    /* The symmetries that leave the board unchanged (most boards have
+     * none but the identity). */
+    for (unsigned s = 1; s < SYMMETRIES; s++)
+    {
+        if (engine->symmetry (board->size, board->black, s) == board->black &&
+            engine->symmetry (board->size, board->white, s) == board->white)
         {
-            bitboard_t bit = set_bitboard (board->size, i, j);
+            symmetries[count++] = s;
+        }
+    }
 
-            if ((bit & board->next_move) != 0)
-            {
-                next_move.row = i;
-                next_move.column = j;
-                board->next_move &= ~bit;
+    if (count == 0)
+    {
+        return moves;
+    }
 
-                return next_move;
-            }
+    bitboard_t left = moves;
+    bitboard_t unique = 0;
+
+    while (left != 0)
+    {
+        bitboard_t move = left & -left;
+        unique |= move;
+        left &= ~move;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            left &= ~engine->symmetry (board->size, move, symmetries[i]);
         }
     }
 
-    return next_move;
+    return unique;
+}
+
+move_iter_t
+move_iter_init (const board_t *board)
+{
+    return (move_iter_t) {.moves = board_moves (board),
+                          .size = board_size (board)};
+}
+
+bool
+move_iter_next (move_iter_t *iter, move_t *move)
+{
+    if (iter == NULL || move == NULL || iter->moves == 0)
+    {
+        return false;
+    }
+
+    /* The lowest bit is the first move in the order of the rows and then of
+     * the columns. */
+    size_t index = engine_for_size (iter->size)->pop_first_bit (&iter->moves);
+    move->row = index / iter->size;
+    move->column = index % iter->size;
+
+    return true;
 }
 
 
@@ -812,7 +982,7 @@ get_corners_to_exam (const board_t *board)
 
     /* Verification if we have more than 1 corner available to play. */
     if (playable_corner == (bitboard_t) 0 ||
-        bitboard_popcount (playable_corner) == 1)
+        board->engine->popcount (playable_corner) == 1)
     {
         return playable_corner;
     }
@@ -1089,8 +1259,8 @@ get_interesting_borders (const board_t *board)
             /* Test if end of game. */
             if (board_player (copy) == EMPTY_DISC)
             {
-                int score  = bitboard_popcount (copy->black) -
-                             bitboard_popcount (copy->white);
+                int score  = copy->engine->popcount (copy->black) -
+                             copy->engine->popcount (copy->white);
                 score = (player == BLACK_DISC) ? score : -score;
 
                 if (score >= 0)
@@ -0,0 +1,361 @@
+/* Bitboard kernels of a board engine. This file is included by board.c once
+ * for each engine, with:
+ *   KERNEL_T     the unsigned integer type that hold the bitboards;
+ *   KERNEL(name) the name of the kernel 'name' in this engine.
+ * The public bitboard_t values are converted to KERNEL_T on input and back on
+ * output: the board size of the engine must fit in KERNEL_T. */
+
+/* Shift the bitboard 'bitboard' by 'offset' bits: to the left if 'offset' is
+ * positive, to the right otherwise. */
+static inline KERNEL_T
+KERNEL (shift_by) (const KERNEL_T bitboard, const int offset)
+{
+    return (offset > 0) ? bitboard << offset : bitboard >> -offset;
+}
+
+/* Offsets of a one square shift in each direction and masks of the squares
+ * that this shift can reach without wrapping around a row, for a board size. */
+typedef struct
+{
+    KERNEL_T masks[DIRECTIONS];
+    int offsets[DIRECTIONS];
+} KERNEL (shifts_t);
+
+/* Shifts tables of every board size that fit in KERNEL_T
+ * (built once at startup by init_shifts ()). */
+static KERNEL (shifts_t) KERNEL (shifts)[MAX_BOARD_SIZE + 1];
+
+/* Build the shifts tables of every board size that fit in KERNEL_T. */
+static void
+KERNEL (init_shifts) (void)
+{
+    for (size_t size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE; size += 2)
+    {
+        if (size * size > sizeof (KERNEL_T) * 8)
+        {
+            break;
+        }
+
+        KERNEL (shifts_t) *shifts = &KERNEL (shifts)[size];
+        KERNEL_T full = ~((KERNEL_T) 0) >> (sizeof (KERNEL_T) * 8 -
+                                            size * size);
+        KERNEL_T first_column = (KERNEL_T) 0;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            first_column |= ((KERNEL_T) 1) << (i * size);
+        }
+
+        KERNEL_T last_column = first_column << (size - 1);
+
+        for (size_t d = 0; d < DIRECTIONS; d++)
+        {
+            /* Bit index = row * size + column. */
+            shifts->offsets[d] = row_direction[d] * (int) size +
+                                 column_direction[d];
+            shifts->masks[d] = full;
+
+            /* A shift to the east can't land on the first column
+             * and a shift to the west can't land on the last one. */
+            if (column_direction[d] < 0)
+            {
+                shifts->masks[d] &= ~last_column;
+            }
+            else if (column_direction[d] > 0)
+            {
+                shifts->masks[d] &= ~first_column;
+            }
+        }
+    }
+}
+
+/* Shift the bitboard by one square in the direction 'd': the discs that
+ * leave the board are lost (no wrapping around the rows or the columns). */
+static inline KERNEL_T
+KERNEL (shift) (const KERNEL (shifts_t) *shifts, const KERNEL_T bitboard,
+                const size_t d)
+{
+    return KERNEL (shift_by) (bitboard, shifts->offsets[d]) & shifts->masks[d];
+}
+
+/* Propagate the discs of 'gen' through the discs of 'pro' in the direction
+ * of 'offset' with a Kogge-Stone parallel prefix: after the step 'step', 'gen'
+ * reach 2 * step - 1 squares and at most size - 2 discs can be aligned. */
+static inline KERNEL_T
+KERNEL (occluded_fill) (const size_t size, KERNEL_T gen, KERNEL_T pro,
+                        int offset)
+{
+    for (size_t step = 1; step + 2 <= size; step <<= 1)
+    {
+        gen |= pro & KERNEL (shift_by) (gen, offset);
+        pro &= KERNEL (shift_by) (pro, offset);
+        offset *= 2;
+    }
+
+    return gen;
+}
+
+/* Compute all the possible moves as HINT_DISC (*) for the current player.
+ * Use a Kogge-Stone occluded fill in each direction: the player discs are
+ * propagated through the opponent discs with shifts of 1, 2, 4 (and 8)
+ * squares, so the whole board is handled in log2 (size) steps. */
+static bitboard_t
+KERNEL (compute_moves) (const size_t size, const bitboard_t player_bitboard,
+                        const bitboard_t opponent_bitboard)
+{
+    KERNEL_T player = (KERNEL_T) player_bitboard;
+    KERNEL_T opponent = (KERNEL_T) opponent_bitboard;
+    const KERNEL (shifts_t) *shifts = &KERNEL (shifts)[size];
+
+    /* The direction 0 has no column mask: masks[0] is the whole board. */
+    KERNEL_T empty = ~(player | opponent) & shifts->masks[0];
+    KERNEL_T possible_moves = 0;
+
+    for (size_t d = 0; d < DIRECTIONS; d++)
+    {
+        KERNEL_T gen = KERNEL (occluded_fill) (size, player,
+                                               opponent & shifts->masks[d],
+                                               shifts->offsets[d]);
+        possible_moves |= KERNEL (shift) (shifts, gen & opponent, d) & empty;
+    }
+
+    return (bitboard_t) possible_moves;
+}
+
+/* Compute in a single pass all the opponent discs reversed by the disc 'bit'
+ * of the player: in each direction, the run of opponent discs that start
+ * next to 'bit' is reversed if it is closed by a player disc. */
+static bitboard_t
+KERNEL (compute_flips) (const size_t size, const bitboard_t player_bitboard,
+                        const bitboard_t opponent_bitboard,
+                        const bitboard_t bit)
+{
+    KERNEL_T player = (KERNEL_T) player_bitboard;
+    KERNEL_T opponent = (KERNEL_T) opponent_bitboard;
+    const KERNEL (shifts_t) *shifts = &KERNEL (shifts)[size];
+    KERNEL_T flips = 0;
+
+    for (size_t d = 0; d < DIRECTIONS; d++)
+    {
+        KERNEL_T gen = KERNEL (occluded_fill) (size, (KERNEL_T) bit,
+                                               opponent & shifts->masks[d],
+                                               shifts->offsets[d]);
+
+        if ((KERNEL (shift) (shifts, gen, d) & player) != 0)
+        {
+            flips |= gen & opponent;
+        }
+    }
+
+    return (bitboard_t) flips;
+}
+
+/* Masks of the first row, of each column and of each diagonal of a board
+ * size, for the symmetries. */
+typedef struct
+{
+    KERNEL_T row;
+    KERNEL_T columns[MAX_BOARD_SIZE];
+    /* Squares of column - row = i - (size - 1). */
+    KERNEL_T diagonals[2 * MAX_BOARD_SIZE - 1];
+} KERNEL (symmetries_t);
+
+/* Symmetries tables of every board size that fit in KERNEL_T
+ * (built once at startup by init_symmetries ()). */
+static KERNEL (symmetries_t) KERNEL (symmetries)[MAX_BOARD_SIZE + 1];
+
+/* Build the symmetries tables of every board size that fit in KERNEL_T. */
+static void
+KERNEL (init_symmetries) (void)
+{
+    for (size_t size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE; size += 2)
+    {
+        if (size * size > sizeof (KERNEL_T) * 8)
+        {
+            break;
+        }
+
+        KERNEL (symmetries_t) *masks = &KERNEL (symmetries)[size];
+        memset (masks, 0, sizeof (KERNEL (symmetries_t)));
+        masks->row = (((KERNEL_T) 1) << size) - 1;
+
+        for (size_t row = 0; row < size; row++)
+        {
+            for (size_t column = 0; column < size; column++)
+            {
+                KERNEL_T bit = ((KERNEL_T) 1) << (row * size + column);
+                masks->columns[column] |= bit;
+                masks->diagonals[column + size - 1 - row] |= bit;
+            }
+        }
+    }
+}
+
+/* Reverse the order of the rows of the bitboard: each row is moved to its
+ * place in one shift. */
+static inline KERNEL_T
+KERNEL (flip_vertical) (const size_t size, const KERNEL_T bitboard)
+{
+    const KERNEL (symmetries_t) *masks = &KERNEL (symmetries)[size];
+    KERNEL_T flipped = 0;
+
+    for (size_t row = 0; row < size; row++)
+    {
+        flipped |= ((bitboard >> (row * size)) & masks->row) <<
+                   ((size - 1 - row) * size);
+    }
+
+    return flipped;
+}
+
+/* Reverse the order of the columns of the bitboard: the column 'column' is
+ * shifted by size - 1 - 2 * column squares. */
+static inline KERNEL_T
+KERNEL (flip_horizontal) (const size_t size, const KERNEL_T bitboard)
+{
+    const KERNEL (symmetries_t) *masks = &KERNEL (symmetries)[size];
+    KERNEL_T flipped = 0;
+
+    for (size_t column = 0; column < size; column++)
+    {
+        flipped |= KERNEL (shift_by) (bitboard & masks->columns[column],
+                                      (int) size - 1 - 2 * (int) column);
+    }
+
+    return flipped;
+}
+
+/* Flip the bitboard on its diagonal (the square (row, column) goes to
+ * (column, row)): the squares of a same diagonal column - row = k all move
+ * by k * (size - 1) bits. */
+static inline KERNEL_T
+KERNEL (flip_diagonal) (const size_t size, const KERNEL_T bitboard)
+{
+    const KERNEL (symmetries_t) *masks = &KERNEL (symmetries)[size];
+    KERNEL_T flipped = 0;
+
+    for (size_t i = 0; i < 2 * size - 1; i++)
+    {
+        int k = (int) i - (int) size + 1;
+        flipped |= KERNEL (shift_by) (bitboard & masks->diagonals[i],
+                                      k * ((int) size - 1));
+    }
+
+    return flipped;
+}
+
+/* Rotate the bitboard by 90 degrees clockwise (the square (row, column)
+ * goes to (column, size - 1 - row)). */
+static inline KERNEL_T
+KERNEL (rotate) (const size_t size, const KERNEL_T bitboard)
+{
+    return KERNEL (flip_horizontal) (size,
+                                     KERNEL (flip_diagonal) (size, bitboard));
+}
+
+/* Apply the symmetry 'symmetry' to the bitboard (see bitboard_symmetry ()):
+ * the rotations are a flip on the diagonal followed by another flip, as
+ * rotate (). */
+static bitboard_t
+KERNEL (symmetry) (const size_t size, const bitboard_t bitboard,
+                   const unsigned symmetry)
+{
+    KERNEL_T image = (KERNEL_T) bitboard;
+
+    if (symmetry & SYMMETRY_FLIP_DIAGONAL)
+    {
+        image = KERNEL (flip_diagonal) (size, image);
+    }
+
+    if (symmetry & SYMMETRY_FLIP_VERTICAL)
+    {
+        image = KERNEL (flip_vertical) (size, image);
+    }
+
+    if (symmetry & SYMMETRY_FLIP_HORIZONTAL)
+    {
+        image = KERNEL (flip_horizontal) (size, image);
+    }
+
+    return (bitboard_t) image;
+}
+
+/* A SWAR popcount on each 64 bits word of the bitboard
+ * (portable version, see popcount_hw () for the hardware one). */
+static size_t
+KERNEL (popcount) (const bitboard_t bitboard)
+{
+    const uint64_t only_3 = 0x3333333333333333;
+    const uint64_t only_5 = 0x5555555555555555;
+    const uint64_t only_0F = 0x0F0F0F0F0F0F0F0F;
+    const uint64_t only_01 = 0x0101010101010101;
+    KERNEL_T copy = (KERNEL_T) bitboard;
+    size_t count = 0;
+
+    for (size_t i = 0; i < sizeof (KERNEL_T) / sizeof (uint64_t); i++)
+    {
+        uint64_t word = (uint64_t) copy;
+        word -= ((word >> 1) & only_5);
+        word = (word & only_3) + ((word >> 2) & only_3);
+        word = (word + (word >> 4)) & only_0F;
+        count += (word * only_01) >> 56;
+        /* Two shifts: a 64 bits shift is undefined on a 64 bits KERNEL_T. */
+        copy >>= 32;
+        copy >>= 32;
+    }
+
+    return count;
+}
+
+/* Clear the lowest bit of the (not empty) bitboard and return its index: the
+ * index is the number of bits under the lowest one (portable version, see
+ * pop_first_bit_hw () for the hardware one). */
+static size_t
+KERNEL (pop_first_bit) (bitboard_t *bitboard)
+{
+    KERNEL_T copy = (KERNEL_T) *bitboard;
+    KERNEL_T lowest = copy & -copy;
+    *bitboard = (bitboard_t) (copy ^ lowest);
+
+    return KERNEL (popcount) ((bitboard_t) (lowest - 1));
+}
+
+#if defined (__x86_64__)
+/* Same as popcount () with the POPCNT instruction. */
+static size_t __attribute__ ((target ("popcnt")))
+KERNEL (popcount_hw) (const bitboard_t bitboard)
+{
+    KERNEL_T copy = (KERNEL_T) bitboard;
+    size_t count = 0;
+
+    for (size_t i = 0; i < sizeof (KERNEL_T) / sizeof (uint64_t); i++)
+    {
+        count += __builtin_popcountll ((uint64_t) copy);
+        copy >>= 32;
+        copy >>= 32;
+    }
+
+    return count;
+}
+
+/* Same as pop_first_bit () with the TZCNT and BLSR instructions. */
+static size_t __attribute__ ((target ("bmi")))
+KERNEL (pop_first_bit_hw) (bitboard_t *bitboard)
+{
+    KERNEL_T copy = (KERNEL_T) *bitboard;
+    *bitboard = (bitboard_t) (copy & (copy - 1));
+
+    uint64_t word = (uint64_t) copy;
+    size_t index = 0;
+
+    /* Only the 128 bits engine can have its lowest bit in its second word. */
+    if (word == 0)
+    {
+        copy >>= 32;
+        word = (uint64_t) (copy >> 32);
+        index = 64;
+    }
+
+    return index + __builtin_ctzll (word);
+}
+#endif
@@ -0,0 +1,278 @@
+#define _POSIX_C_SOURCE 200809L /* To use mmap (). */
+
+#include <book.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/********************************* Constants **********************************/
+
+/* Magic number and version of the book files. */
+static const char book_magic[4] = {'R', 'B', 'O', 'K'};
+static const uint32_t book_version = 2;
+
+
+/********************************* Structures *********************************/
+
+/* Header of a book file (16 bytes, so the entries are aligned). */
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;    /* Number of entries. */
+} book_header_t;
+
+/* Internal book_t structure (hiden from the outside). */
+struct book_t
+{
+    void *map;                  /* The whole file. */
+    size_t length;
+    const book_entry_t *entries;
+    size_t count;
+};
+
+
+/****************************** Internal tools *******************************/
+
+/* Order of the entries in a book file: by key, then by move. */
+static int
+entry_compare (const void *a, const void *b)
+{
+    const book_entry_t *x = a;
+    const book_entry_t *y = b;
+
+    if (x->key != y->key)
+    {
+        return (x->key < y->key) ? -1 : 1;
+    }
+
+    return (int) x->move - (int) y->move;
+}
+
+/* Index of the first entry of 'book' with a key not lower than 'key' (a
+ * binary search: only the pages of the entries read are loaded). */
+static size_t
+lower_bound (const book_t *book, const uint64_t key)
+{
+    size_t low = 0;
+    size_t high = book->count;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (book->entries[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+/******************************* Opening book *********************************/
+
+uint64_t
+book_key (const board_t *board, unsigned *symmetry)
+{
+    return board_canonical_hash (board, symmetry);
+}
+
+book_entry_t
+book_entry (const board_t *board, const move_t move, const int score,
+            const size_t depth)
+{
+    unsigned symmetry;
+    uint64_t key = book_key (board, &symmetry);
+    move_t image = move_symmetry (board_size (board), move, symmetry);
+
+    return (book_entry_t) {.key = key,
+                           .score = score,
+                           .move = image.row * MAX_BOARD_SIZE + image.column,
+                           .depth = (depth > UINT8_MAX) ? UINT8_MAX : depth,
+                           .reserved = 0};
+}
+
+book_t*
+book_open (const char *filename)
+{
+    int fd = open (filename, O_RDONLY);
+
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    struct stat status;
+
+    if (fstat (fd, &status) == -1 ||
+        (size_t) status.st_size < sizeof (book_header_t))
+    {
+        close (fd);
+
+        return NULL;
+    }
+
+    size_t length = status.st_size;
+    void *map = mmap (NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+
+    /* The mapping stays valid once the file is closed. */
+    close (fd);
+
+    if (map == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const book_header_t *header = map;
+    book_t *book = malloc (sizeof (book_t));
+
+    if (book == NULL ||
+        memcmp (header->magic, book_magic, sizeof (book_magic)) != 0 ||
+        header->version != book_version ||
+        header->count > (length - sizeof (book_header_t)) /
+                        sizeof (book_entry_t))
+    {
+        free (book);
+        munmap (map, length);
+
+        return NULL;
+    }
+
+    book->map = map;
+    book->length = length;
+    book->entries = (const book_entry_t *) (header + 1);
+    book->count = header->count;
+
+    return book;
+}
+
+void
+book_close (book_t *book)
+{
+    if (book == NULL)
+    {
+        return;
+    }
+
+    munmap (book->map, book->length);
+    free (book);
+}
+
+const book_entry_t*
+book_entries (const book_t *book, size_t *count)
+{
+    if (book == NULL)
+    {
+        *count = 0;
+
+        return NULL;
+    }
+
+    *count = book->count;
+
+    return book->entries;
+}
+
+size_t
+book_find (const book_t *book, const uint64_t key,
+           const book_entry_t **entries)
+{
+    if (book == NULL)
+    {
+        return 0;
+    }
+
+    size_t first = lower_bound (book, key);
+    size_t last = first;
+
+    while (last < book->count && book->entries[last].key == key)
+    {
+        last++;
+    }
+
+    *entries = &book->entries[first];
+
+    return last - first;
+}
+
+bool
+book_lookup (const book_t *book, const board_t *board, move_t *move,
+             int *score)
+{
+    if (book == NULL || board == NULL || board_player (board) == EMPTY_DISC)
+    {
+        return false;
+    }
+
+    unsigned symmetry;
+    const book_entry_t *entries;
+    size_t count = book_find (book, book_key (board, &symmetry), &entries);
+    /* The moves of the book go back from the canonical form to 'board'. */
+    unsigned inverse = symmetry_inverse (symmetry);
+    bool found = false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const book_entry_t *entry = &entries[i];
+        move_t entry_move = {.row = entry->move / MAX_BOARD_SIZE,
+                             .column = entry->move % MAX_BOARD_SIZE};
+        entry_move = move_symmetry (board_size (board), entry_move, inverse);
+
+        /* A move not possible here is from another position of same key. */
+        if (!board_is_move_valid (board, entry_move))
+        {
+            continue;
+        }
+
+        if (!found || entry->score > *score)
+        {
+            *move = entry_move;
+            *score = entry->score;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+bool
+book_write (const char *filename, book_entry_t *entries, const size_t count)
+{
+    FILE *file = fopen (filename, "wb");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    qsort (entries, count, sizeof (book_entry_t), entry_compare);
+
+    /* Keep one entry of each move of a position. */
+    size_t unique = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (unique == 0 || entry_compare (&entries[unique - 1],
+                                          &entries[i]) != 0)
+        {
+            entries[unique++] = entries[i];
+        }
+    }
+
+    book_header_t header = {.version = book_version, .count = unique};
+    memcpy (header.magic, book_magic, sizeof (book_magic));
+
+    bool ok = fwrite (&header, sizeof (header), 1, file) == 1 &&
+              fwrite (entries, sizeof (book_entry_t), unique, file) == unique;
+
+    return fclose (file) == 0 && ok;
+}
@@ -0,0 +1,563 @@
+#define _POSIX_C_SOURCE 200809L /* To use clock_gettime () and access (). */
+
+#include <book_builder.h>
+#include <book.h>
+#include <player.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/********************************* Constants **********************************/
+
+/* Plies of the opening tree and depth of the searches of its leaves for the
+ * sizes 4, 6, 8 and 10 (two more than the depth of newton_player). The 4x4
+ * leaves are all solved by the endgame solver. */
+static const size_t default_plies[4] = {6, 6, 6, 4};
+static const size_t default_depth[4] = {14, 12, 9, 7};
+
+/* The book is written each time this number of leaves are searched, so a
+ * stopped build loses at most their searches. */
+static const size_t checkpoint_leaves = 256;
+
+
+/********************************* Structures *********************************/
+
+/* A position at the end of the opening tree. Its entry is its best move and
+ * the score of this move (of depth 0 until it is known). */
+typedef struct
+{
+    board_t *board;
+    book_entry_t entry;
+} leaf_t;
+
+/* A growing array of entries. */
+typedef struct
+{
+    book_entry_t *entries;
+    size_t count;
+    size_t capacity;
+} entry_list_t;
+
+/* The opening tree of a build. */
+typedef struct
+{
+    leaf_t *leaves;         /* Sorted by key once all are collected. */
+    size_t count;
+    size_t capacity;
+    size_t depth;           /* Depth of the searches of the leaves. */
+    entry_list_t interior;  /* Entries of the moves of the other nodes. */
+} tree_t;
+
+/* What the threads searching the leaves share. */
+typedef struct
+{
+    leaf_t **leaves;        /* Leaves to search. */
+    size_t count;
+    atomic_size_t next;     /* Next leaf to take. */
+    size_t depth;
+} build_work_t;
+
+/* A helper thread of the searches of the leaves. */
+typedef struct
+{
+    pthread_t thread;
+    build_work_t *work;
+} build_worker_t;
+
+
+/****************************** Internal tools *******************************/
+
+/* Seconds elapsed since 'start'. */
+static double
+elapsed (const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) +
+           (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Order of the entries by key. */
+static int
+key_compare (const void *a, const void *b)
+{
+    const book_entry_t *x = a;
+    const book_entry_t *y = b;
+
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+/* Order of the leaves by key. */
+static int
+leaf_compare (const void *a, const void *b)
+{
+    const leaf_t *x = a;
+    const leaf_t *y = b;
+
+    return key_compare (&x->entry, &y->entry);
+}
+
+/* Append 'entry' to 'list'
+ *   -> return false if the allocation failed. */
+static bool
+entry_add (entry_list_t *list, const book_entry_t entry)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = (list->capacity == 0) ? 1024 : 2 * list->capacity;
+        book_entry_t *entries = realloc (list->entries,
+                                         capacity * sizeof (book_entry_t));
+
+        if (entries == NULL)
+        {
+            return false;
+        }
+
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+
+    list->entries[list->count++] = entry;
+
+    return true;
+}
+
+/* Final disc difference of the finished game 'board' for 'player'. */
+static int
+final_score (const board_t *board, const disc_t player)
+{
+    score_t score = board_score (board);
+    int difference = (int) score.black - (int) score.white;
+
+    return (player == BLACK_DISC) ? difference : -difference;
+}
+
+
+/******************************* Opening tree *********************************/
+
+/* Copy in 'tree' the positions 'plies' plies below 'board' (the finished
+ * games on the way are not leaves)
+ *   -> return false if an allocation failed. */
+static bool
+collect_leaves (tree_t *tree, board_t *board, const size_t plies)
+{
+    if (board_player (board) == EMPTY_DISC)
+    {
+        return true;
+    }
+
+    if (plies == 0)
+    {
+        if (tree->count == tree->capacity)
+        {
+            size_t capacity = (tree->capacity == 0) ? 1024 :
+                                                      2 * tree->capacity;
+            leaf_t *leaves = realloc (tree->leaves,
+                                      capacity * sizeof (leaf_t));
+
+            if (leaves == NULL)
+            {
+                return false;
+            }
+
+            tree->leaves = leaves;
+            tree->capacity = capacity;
+        }
+
+        leaf_t *leaf = &tree->leaves[tree->count];
+        leaf->board = board_copy (board);
+        leaf->entry = (book_entry_t) {.key = book_key (board, NULL)};
+
+        if (leaf->board == NULL)
+        {
+            return false;
+        }
+
+        tree->count++;
+
+        return true;
+    }
+
+    bool ok = true;
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
+    while (ok && move_iter_next (&iter, &move))
+    {
+        undo_t undo;
+
+        board_do_move (board, move, &undo);
+        ok = collect_leaves (tree, board, plies - 1);
+        board_undo_move (board, &undo);
+    }
+
+    return ok;
+}
+
+/* Sort the leaves of 'tree' by key and keep one leaf of each position (the
+ * transpositions reach the same leaves by several paths, and the symmetric
+ * leaves are the same position in the book). */
+static void
+unique_leaves (tree_t *tree)
+{
+    size_t count = 0;
+
+    qsort (tree->leaves, tree->count, sizeof (leaf_t), leaf_compare);
+
+    for (size_t i = 0; i < tree->count; i++)
+    {
+        if (count > 0 &&
+            tree->leaves[count - 1].entry.key == tree->leaves[i].entry.key)
+        {
+            board_free (tree->leaves[i].board);
+        }
+        else
+        {
+            tree->leaves[count++] = tree->leaves[i];
+        }
+    }
+
+    tree->count = count;
+}
+
+/* Give to the leaves of 'tree' the best entry of 'book' of their position
+ * searched at least to the depth of the tree
+ *   -> return the number of leaves found. */
+static size_t
+find_leaves (tree_t *tree, const book_t *book)
+{
+    size_t found = 0;
+
+    for (size_t i = 0; i < tree->count; i++)
+    {
+        leaf_t *leaf = &tree->leaves[i];
+        const book_entry_t *entries;
+        size_t count = book_find (book, leaf->entry.key, &entries);
+
+        for (size_t j = 0; j < count; j++)
+        {
+            if (entries[j].depth >= tree->depth &&
+                (leaf->entry.depth == 0 ||
+                 entries[j].score > leaf->entry.score))
+            {
+                leaf->entry = entries[j];
+            }
+        }
+
+        found += (leaf->entry.depth > 0);
+    }
+
+    return found;
+}
+
+/* Value of 'board' for the player to move, negamaxed from the leaves of
+ * 'tree' 'plies' plies below it. The entries of its moves are added to the
+ * tree ('ok' become false if an allocation failed). */
+static int
+tree_value (tree_t *tree, board_t *board, const size_t plies, bool *ok)
+{
+    disc_t player = board_player (board);
+    int best_value = INT16_MIN;
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
+    while (move_iter_next (&iter, &move))
+    {
+        undo_t undo;
+        int value;
+
+        board_do_move (board, move, &undo);
+        disc_t next_player = board_player (board);
+
+        if (next_player == EMPTY_DISC)
+        {
+            value = final_score (board, player);
+        }
+        else
+        {
+            if (plies > 1)
+            {
+                value = tree_value (tree, board, plies - 1, ok);
+            }
+            else
+            {
+                leaf_t child = {.entry = {.key = book_key (board, NULL)}};
+                leaf_t *leaf = bsearch (&child, tree->leaves, tree->count,
+                                        sizeof (leaf_t), leaf_compare);
+                value = leaf->entry.score;
+            }
+
+            /* A pass let the same player play again. */
+            value = (next_player == player) ? value : -value;
+        }
+
+        board_undo_move (board, &undo);
+
+        *ok = *ok && entry_add (&tree->interior,
+                                book_entry (board, move, value,
+                                            plies - 1 + tree->depth));
+
+        if (value > best_value)
+        {
+            best_value = value;
+        }
+    }
+
+    return best_value;
+}
+
+
+/******************************* Leaf searches ********************************/
+
+/* Search the leaves of 'work' until there is none left. */
+static void
+search_leaves (build_work_t *work)
+{
+    size_t i;
+
+    while ((i = atomic_fetch_add (&work->next, 1)) < work->count)
+    {
+        leaf_t *leaf = work->leaves[i];
+        move_t move;
+        int score = newton_value (leaf->board, work->depth, &move);
+
+        leaf->entry = book_entry (leaf->board, move, score, work->depth);
+    }
+}
+
+/* Body of a helper thread of the searches of the leaves. */
+static void *
+build_worker (void *worker)
+{
+    build_worker_t *self = worker;
+    search_leaves (self->work);
+
+    return NULL;
+}
+
+/* Search the 'count' leaves 'leaves' to 'depth' with 'threads' threads: each
+ * thread takes the next leaf left. */
+static void
+parallel_search (leaf_t **leaves, const size_t count, const size_t depth,
+                 const size_t threads)
+{
+    build_work_t work = {.leaves = leaves, .count = count, .next = 0,
+                         .depth = depth};
+    size_t helpers = (threads > count) ? count - 1 : threads - 1;
+    build_worker_t *workers = malloc (helpers * sizeof (build_worker_t));
+    size_t started = 0;
+
+    while (workers != NULL && started < helpers)
+    {
+        workers[started].work = &work;
+
+        if (pthread_create (&workers[started].thread, NULL, build_worker,
+                            &workers[started]) != 0)
+        {
+            break;
+        }
+
+        started++;
+    }
+
+    search_leaves (&work);
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join (workers[i].thread, NULL);
+    }
+
+    free (workers);
+}
+
+
+/******************************** Book file ***********************************/
+
+/* Write the book 'filename' with the 'count' entries 'entries' and the
+ * 'old_count' entries 'old' of the positions without any of these entries
+ *   -> return false if it can't be written. */
+static bool
+write_book (const char *filename, const book_entry_t *entries,
+            const size_t count, const book_entry_t *old,
+            const size_t old_count)
+{
+    book_entry_t *all = malloc ((count + old_count + 1) *
+                                sizeof (book_entry_t));
+
+    if (all == NULL)
+    {
+        return false;
+    }
+
+    memcpy (all, entries, count * sizeof (book_entry_t));
+    qsort (all, count, sizeof (book_entry_t), key_compare);
+
+    size_t total = count;
+
+    for (size_t i = 0; i < old_count; i++)
+    {
+        if (bsearch (&old[i], all, count, sizeof (book_entry_t),
+                     key_compare) == NULL)
+        {
+            all[total++] = old[i];
+        }
+    }
+
+    bool ok = book_write (filename, all, total);
+    free (all);
+
+    return ok;
+}
+
+/* Write the book 'filename' with the entries of the leaves of 'tree' already
+ * known (and the entries of its interior nodes if 'interior') and the
+ * 'old_count' entries 'old' of the other positions
+ *   -> return false if it can't be written. */
+static bool
+write_tree (const char *filename, const tree_t *tree, const bool interior,
+            const book_entry_t *old, const size_t old_count)
+{
+    entry_list_t list = {.entries = NULL, .count = 0, .capacity = 0};
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < tree->count; i++)
+    {
+        if (tree->leaves[i].entry.depth > 0)
+        {
+            ok = entry_add (&list, tree->leaves[i].entry);
+        }
+    }
+
+    for (size_t i = 0; ok && interior && i < tree->interior.count; i++)
+    {
+        ok = entry_add (&list, tree->interior.entries[i]);
+    }
+
+    ok = ok && write_book (filename, list.entries, list.count, old,
+                           old_count);
+    free (list.entries);
+
+    return ok;
+}
+
+
+/******************************* Book building ********************************/
+
+bool
+book_defaults (const size_t size, size_t *plies, size_t *depth)
+{
+    if (size < 4 || size > 10 || size % 2 != 0)
+    {
+        return false;
+    }
+
+    *plies = default_plies[size / 2 - 2];
+    *depth = default_depth[size / 2 - 2];
+
+    return true;
+}
+
+bool
+book_build (const char *filename, const size_t size, const size_t plies,
+            const size_t depth, const size_t threads, FILE *fd)
+{
+    struct timespec start;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    /* Keep the entries of the book to extend. */
+    book_t *book = book_open (filename);
+
+    if (book == NULL && access (filename, F_OK) == 0)
+    {
+        fprintf (fd, "book: '%s' is not a book\n", filename);
+
+        return false;
+    }
+
+    board_t *board = board_init (size);
+    tree_t tree = {.leaves = NULL, .count = 0, .capacity = 0, .depth = depth,
+                   .interior = {.entries = NULL, .count = 0, .capacity = 0}};
+    bool ok = board != NULL && plies > 0 && depth > 0 &&
+              collect_leaves (&tree, board, plies);
+    size_t old_count;
+    const book_entry_t *entries = book_entries (book, &old_count);
+    book_entry_t *old = malloc ((old_count + 1) * sizeof (book_entry_t));
+    leaf_t **todo = malloc ((tree.count + 1) * sizeof (leaf_t *));
+    size_t todo_count = 0;
+
+    ok = ok && old != NULL && todo != NULL;
+
+    if (ok)
+    {
+        /* The book file is rewritten: its mapping must not be used then. */
+        if (old_count > 0)
+        {
+            memcpy (old, entries, old_count * sizeof (book_entry_t));
+        }
+
+        unique_leaves (&tree);
+        size_t found = find_leaves (&tree, book);
+
+        for (size_t i = 0; i < tree.count; i++)
+        {
+            if (tree.leaves[i].entry.depth == 0)
+            {
+                todo[todo_count++] = &tree.leaves[i];
+            }
+        }
+
+        fprintf (fd, "book: %zux%zu, %zu plies, %zu leaves (%zu already in "
+                 "the book), searched to depth %zu with %zu thread%s\n",
+                 size, size, plies, tree.count, found, depth, threads,
+                 (threads > 1) ? "s" : "");
+    }
+
+    book_close (book);
+
+    for (size_t i = 0; ok && i < todo_count; i += checkpoint_leaves)
+    {
+        size_t count = (todo_count - i < checkpoint_leaves) ?
+                       todo_count - i : checkpoint_leaves;
+
+        parallel_search (&todo[i], count, depth, threads);
+        ok = write_tree (filename, &tree, false, old, old_count);
+        fprintf (fd, "book: %zu / %zu leaves searched in %.1f s\n",
+                 i + count, todo_count, elapsed (&start));
+        fflush (fd);
+    }
+
+    if (ok)
+    {
+        int value = tree_value (&tree, board, plies, &ok);
+        ok = ok && write_tree (filename, &tree, true, old, old_count);
+
+        if (ok)
+        {
+            fprintf (fd, "book: value of the start position %+d, written "
+                     "in '%s' in %.1f s\n", value, filename,
+                     elapsed (&start));
+        }
+    }
+
+    if (!ok)
+    {
+        fprintf (fd, "book: impossible to build '%s'\n", filename);
+    }
+
+    for (size_t i = 0; i < tree.count; i++)
+    {
+        board_free (tree.leaves[i].board);
+    }
+
+    free (tree.leaves);
+    free (tree.interior.entries);
+    free (todo);
+    free (old);
+    board_free (board);
+
+    return ok;
+}
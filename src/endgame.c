@@ -0,0 +1,581 @@
+#include <endgame.h>
+
+#include <stdint.h>
+
+
+/********************************* Structures *********************************/
+
+/* What a search of the solver need to know beside the discs. */
+typedef struct
+{
+    size_t size;
+    bitboard_t quadrants[4]; /* Regions of the parity ordering. */
+    tt_t *tt;
+    size_t *nodes; /* Positions visited by the search. */
+} solver_t;
+
+/* A possible move with its reversed discs and its score for the ordering. */
+typedef struct
+{
+    bitboard_t bit;
+    bitboard_t flips;
+    int score;
+} solver_move_t;
+
+
+/********************************* Constants **********************************/
+
+/* Bigger than any disc difference. */
+static const int score_infinity = MAX_BOARD_SIZE * MAX_BOARD_SIZE + 1;
+
+/* Under these numbers of empties, the solver doesn't use the transposition
+ * table and doesn't order the moves by mobility (it costs more than it
+ * saves near the end). */
+static const size_t tt_empties = 8;
+static const size_t fastest_first_empties = 7;
+
+/* Scores of the move ordering: the move of the transposition table first,
+ * then the less moves left to the opponent, then the moves in a region with
+ * an odd number of empties. */
+static const int order_tt_move = 1 << 20;
+static const int order_mobility = 16;
+static const int order_parity = 8;
+
+
+/****************************** Internal tools *******************************/
+
+/* Final disc difference for 'player' (the empties are not counted). */
+static int
+final_score (const bitboard_t player, const bitboard_t opponent)
+{
+    return (int) bitboard_popcount (player) -
+           (int) bitboard_popcount (opponent);
+}
+
+/* SplitMix64 finalizer. */
+static uint64_t
+mix (uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Hash of a position of the solver for the transposition table. */
+static uint64_t
+solver_hash (const bitboard_t player, const bitboard_t opponent)
+{
+    uint64_t hash = mix ((uint64_t) (opponent >> 64));
+    hash = mix (hash ^ (uint64_t) opponent);
+    hash = mix (hash ^ (uint64_t) (player >> 64));
+
+    return mix (hash ^ (uint64_t) player);
+}
+
+/* Squares of the regions with an odd number of empties. */
+static bitboard_t
+odd_regions (const solver_t *solver, const bitboard_t empties)
+{
+    bitboard_t odd = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (bitboard_popcount (empties & solver->quadrants[i]) % 2 == 1)
+        {
+            odd |= solver->quadrants[i];
+        }
+    }
+
+    return odd;
+}
+
+
+/********************************* Last moves *********************************/
+
+/* The last empties are played without move generation nor transposition
+ * table: each empty square is tried directly, in the parity order. */
+
+/* Exact score with the last empty 'x'. */
+static int
+solve_1 (const solver_t *solver, const bitboard_t player,
+         const bitboard_t opponent, const bitboard_t x)
+{
+    (*solver->nodes)++;
+
+    int score = final_score (player, opponent);
+    bitboard_t flips = bitboard_flips (solver->size, player, opponent, x);
+
+    if (flips != 0)
+    {
+        return score + 2 * (int) bitboard_popcount (flips) + 1;
+    }
+
+    /* Player pass. */
+    flips = bitboard_flips (solver->size, opponent, player, x);
+
+    if (flips != 0)
+    {
+        return score - 2 * (int) bitboard_popcount (flips) - 1;
+    }
+
+    return score;
+}
+
+/* Exact score with the last empties 'x' ('passed' if the opponent just
+ * passed). */
+static int
+solve_2 (const solver_t *solver, const bitboard_t player,
+         const bitboard_t opponent, const int alpha, const int beta,
+         const bitboard_t x[2], const bool passed)
+{
+    (*solver->nodes)++;
+
+    int best = -score_infinity;
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        bitboard_t flips = bitboard_flips (solver->size, player, opponent,
+                                           x[i]);
+
+        if (flips == 0)
+        {
+            continue;
+        }
+
+        int value = -solve_1 (solver, opponent ^ flips, player ^ flips ^ x[i],
+                              x[1 - i]);
+
+        if (value > best)
+        {
+            best = value;
+
+            if (best >= beta)
+            {
+                return best;
+            }
+        }
+    }
+
+    if (best != -score_infinity)
+    {
+        return best;
+    }
+
+    /* Nobody can play: game over. */
+    if (passed)
+    {
+        return final_score (player, opponent);
+    }
+
+    return -solve_2 (solver, opponent, player, -beta, -alpha, x, true);
+}
+
+/* Exact score with the last empties 'x' ('passed' if the opponent just
+ * passed). */
+static int
+solve_3 (const solver_t *solver, const bitboard_t player,
+         const bitboard_t opponent, int alpha, const int beta,
+         const bitboard_t x[3], const bool passed)
+{
+    (*solver->nodes)++;
+
+    int best = -score_infinity;
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        bitboard_t flips = bitboard_flips (solver->size, player, opponent,
+                                           x[i]);
+
+        if (flips == 0)
+        {
+            continue;
+        }
+
+        /* The other empties, in the same order. */
+        bitboard_t rest[2] = {x[(i == 0) ? 1 : 0], x[(i == 2) ? 1 : 2]};
+        int value = -solve_2 (solver, opponent ^ flips, player ^ flips ^ x[i],
+                              -beta, -alpha, rest, false);
+
+        if (value > best)
+        {
+            best = value;
+
+            if (best >= beta)
+            {
+                return best;
+            }
+
+            if (best > alpha)
+            {
+                alpha = best;
+            }
+        }
+    }
+
+    if (best != -score_infinity)
+    {
+        return best;
+    }
+
+    /* Nobody can play: game over. */
+    if (passed)
+    {
+        return final_score (player, opponent);
+    }
+
+    return -solve_3 (solver, opponent, player, -beta, -alpha, x, true);
+}
+
+/* Exact score with the last empties 'x' ('passed' if the opponent just
+ * passed). */
+static int
+solve_4 (const solver_t *solver, const bitboard_t player,
+         const bitboard_t opponent, int alpha, const int beta,
+         const bitboard_t x[4], const bool passed)
+{
+    (*solver->nodes)++;
+
+    int best = -score_infinity;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        bitboard_t flips = bitboard_flips (solver->size, player, opponent,
+                                           x[i]);
+
+        if (flips == 0)
+        {
+            continue;
+        }
+
+        /* The other empties, in the same order. */
+        bitboard_t rest[3];
+
+        for (size_t j = 0, k = 0; j < 4; j++)
+        {
+            if (j != i)
+            {
+                rest[k++] = x[j];
+            }
+        }
+
+        int value = -solve_3 (solver, opponent ^ flips, player ^ flips ^ x[i],
+                              -beta, -alpha, rest, false);
+
+        if (value > best)
+        {
+            best = value;
+
+            if (best >= beta)
+            {
+                return best;
+            }
+
+            if (best > alpha)
+            {
+                alpha = best;
+            }
+        }
+    }
+
+    if (best != -score_infinity)
+    {
+        return best;
+    }
+
+    /* Nobody can play: game over. */
+    if (passed)
+    {
+        return final_score (player, opponent);
+    }
+
+    return -solve_4 (solver, opponent, player, -beta, -alpha, x, true);
+}
+
+/* Exact score with the 4 or less 'empties', the squares of the regions with
+ * an odd number of empties first. */
+static int
+solve_last (const solver_t *solver, const bitboard_t player,
+            const bitboard_t opponent, const int alpha, const int beta,
+            const bitboard_t empties)
+{
+    bitboard_t odd = odd_regions (solver, empties);
+    bitboard_t x[4];
+    size_t count = 0;
+
+    for (bitboard_t squares = empties & odd; squares != 0;)
+    {
+        x[count++] = (bitboard_t) 1 << bitboard_pop_first_bit (&squares);
+    }
+
+    for (bitboard_t squares = empties & ~odd; squares != 0;)
+    {
+        x[count++] = (bitboard_t) 1 << bitboard_pop_first_bit (&squares);
+    }
+
+    switch (count)
+    {
+        case 0 :
+            return final_score (player, opponent);
+
+        case 1 :
+            return solve_1 (solver, player, opponent, x[0]);
+
+        case 2 :
+            return solve_2 (solver, player, opponent, alpha, beta, x, false);
+
+        case 3 :
+            return solve_3 (solver, player, opponent, alpha, beta, x, false);
+
+        default :
+            return solve_4 (solver, player, opponent, alpha, beta, x, false);
+    }
+}
+
+
+/******************************* General search *******************************/
+
+/* Fill 'list' with the moves 'moves' of 'player' and their score for the
+ * ordering ('tt_bit' is the move of the transposition table)
+ *   -> return the number of moves. */
+static size_t
+order_moves (const solver_t *solver, const bitboard_t player,
+             const bitboard_t opponent, bitboard_t moves,
+             const bitboard_t empties, const bitboard_t tt_bit,
+             solver_move_t *list)
+{
+    bitboard_t odd = odd_regions (solver, empties);
+    bool fastest_first = bitboard_popcount (empties) >= fastest_first_empties;
+    size_t count = 0;
+
+    while (moves != 0)
+    {
+        bitboard_t bit = (bitboard_t) 1 << bitboard_pop_first_bit (&moves);
+        bitboard_t flips = bitboard_flips (solver->size, player, opponent, bit);
+        int score = ((bit & odd) != 0) ? order_parity : 0;
+
+        if (bit == tt_bit)
+        {
+            score = order_tt_move;
+        }
+        else if (fastest_first)
+        {
+            bitboard_t opponent_moves = bitboard_moves (solver->size,
+                                                        opponent ^ flips,
+                                                        player ^ flips ^ bit);
+            score -= order_mobility * (int) bitboard_popcount (opponent_moves);
+        }
+
+        list[count++] = (solver_move_t) {bit, flips, score};
+    }
+
+    return count;
+}
+
+/* Put the best move of list[i], ..., list[count - 1] in list[i]. */
+static void
+pick_move (solver_move_t *list, const size_t i, const size_t count)
+{
+    size_t best = i;
+
+    for (size_t j = i + 1; j < count; j++)
+    {
+        if (list[j].score > list[best].score)
+        {
+            best = j;
+        }
+    }
+
+    solver_move_t swap = list[i];
+    list[i] = list[best];
+    list[best] = swap;
+}
+
+/* Exact score of the position for 'player' with the window ['alpha', 'beta']
+ * as a principal variation search (fail-soft): the first move with the whole
+ * window, the next ones with a null window ('passed' if the opponent just
+ * passed). If 'best_move' is not NULL, the best move is stored in it. */
+static int
+solve (const solver_t *solver, const bitboard_t player,
+       const bitboard_t opponent, int alpha, const int beta,
+       const bool passed, bitboard_t *best_move)
+{
+    (*solver->nodes)++;
+
+    size_t squares = solver->size * solver->size;
+    bitboard_t empties = ~(player | opponent) &
+                         (((bitboard_t) 1 << squares) - 1);
+    size_t count = bitboard_popcount (empties);
+
+    if (count <= 4 && best_move == NULL)
+    {
+        return solve_last (solver, player, opponent, alpha, beta, empties);
+    }
+
+    bitboard_t moves = bitboard_moves (solver->size, player, opponent);
+
+    if (moves == 0)
+    {
+        /* Nobody can play: game over. */
+        if (passed)
+        {
+            return final_score (player, opponent);
+        }
+
+        return -solve (solver, opponent, player, -beta, -alpha, true, NULL);
+    }
+
+    uint64_t hash = solver_hash (player, opponent);
+    bool use_tt = solver->tt != NULL && count >= tt_empties;
+    bitboard_t tt_bit = 0;
+    tt_data_t data;
+
+    if (use_tt && tt_probe (solver->tt, hash, &data))
+    {
+        if (data.move.row < solver->size)
+        {
+            tt_bit = (bitboard_t) 1 << (data.move.row * solver->size +
+                                        data.move.column);
+        }
+
+        if (best_move == NULL &&
+            (data.bound == TT_EXACT ||
+             (data.bound == TT_LOWER && data.score >= beta) ||
+             (data.bound == TT_UPPER && data.score <= alpha)))
+        {
+            return data.score;
+        }
+    }
+
+    const int alpha_ini = alpha;
+    int best = -score_infinity;
+    bitboard_t best_bit = 0;
+    solver_move_t list[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    size_t number = order_moves (solver, player, opponent, moves, empties,
+                                 tt_bit, list);
+
+    for (size_t i = 0; i < number; i++)
+    {
+        pick_move (list, i, number);
+        bitboard_t next_player = opponent ^ list[i].flips;
+        bitboard_t next_opponent = player ^ list[i].flips ^ list[i].bit;
+        int value;
+
+        if (i == 0)
+        {
+            value = -solve (solver, next_player, next_opponent, -beta, -alpha,
+                            false, NULL);
+        }
+        else
+        {
+            value = -solve (solver, next_player, next_opponent, -alpha - 1,
+                            -alpha, false, NULL);
+
+            /* Better than the best move: get its exact score. */
+            if (value > alpha && value < beta)
+            {
+                value = -solve (solver, next_player, next_opponent, -beta,
+                                -alpha, false, NULL);
+            }
+        }
+
+        if (value > best)
+        {
+            best = value;
+            best_bit = list[i].bit;
+
+            if (best > alpha)
+            {
+                alpha = best;
+            }
+
+            if (alpha >= beta)
+            {
+                break;
+            }
+        }
+    }
+
+    if (use_tt)
+    {
+        size_t index = bitboard_pop_first_bit (&(bitboard_t) {best_bit});
+        tt_bound_t bound = (best <= alpha_ini) ? TT_UPPER :
+                           (best >= beta) ? TT_LOWER : TT_EXACT;
+
+        tt_store (solver->tt, hash,
+                  &(tt_data_t) {.score = best,
+                                .depth = count,
+                                .bound = bound,
+                                .move = {.row = index / solver->size,
+                                         .column = index % solver->size}});
+    }
+
+    if (best_move != NULL)
+    {
+        *best_move = best_bit;
+    }
+
+    return best;
+}
+
+
+/****************************** Endgame solver *******************************/
+
+move_t
+endgame_best_move (const board_t *board, tt_t *tt, int *score,
+                   size_t *nodes)
+{
+    move_t none = {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
+
+    if (board == NULL || score == NULL || board_player (board) == EMPTY_DISC)
+    {
+        return none;
+    }
+
+    size_t size = board_size (board);
+    size_t half = size / 2;
+    size_t visited = 0;
+    solver_t solver = {.size = size, .quadrants = {0, 0, 0, 0}, .tt = tt,
+                       .nodes = (nodes != NULL) ? nodes : &visited};
+
+    /* The four quarters of the board are the regions of the parity. */
+    for (size_t row = 0; row < size; row++)
+    {
+        for (size_t column = 0; column < size; column++)
+        {
+            size_t region = 2 * (row >= half) + (column >= half);
+            solver.quadrants[region] |= (bitboard_t) 1 << (row * size + column);
+        }
+    }
+
+    disc_t player = board_player (board);
+    disc_t opponent = (player == BLACK_DISC) ? WHITE_DISC : BLACK_DISC;
+    bitboard_t player_discs = board_discs (board, player);
+    bitboard_t opponent_discs = board_discs (board, opponent);
+
+    if (bitboard_moves (size, player_discs, opponent_discs) == 0)
+    {
+        return none;
+    }
+
+    /* Win, draw or loss first: a null window around the draw. */
+    bitboard_t best_bit = 0;
+    *score = solve (&solver, player_discs, opponent_discs, -1, 1, false,
+                    &best_bit);
+
+    /* Then the exact score of the win or of the loss. */
+    if (*score > 0)
+    {
+        *score = solve (&solver, player_discs, opponent_discs, 0,
+                        score_infinity, false, &best_bit);
+    }
+    else if (*score < 0)
+    {
+        *score = solve (&solver, player_discs, opponent_discs,
+                        -score_infinity, 0, false, &best_bit);
+    }
+
+    size_t index = bitboard_pop_first_bit (&best_bit);
+
+    return (move_t) {.row = index / size, .column = index % size};
+}
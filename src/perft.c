@@ -0,0 +1,463 @@
+#define _POSIX_C_SOURCE 200809L /* To use clock_gettime (). */
+
+#include <perft.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/********************************* Constants **********************************/
+
+/* Deepest depth of the reference counts. */
+#define PERFT_MAX_DEPTH 11
+
+/* Leaves of the start positions of the sizes 4, 6, 8 and 10 for the depths
+ * 1 to PERFT_MAX_DEPTH (0 when it is unknown). The whole 4x4 game tree is
+ * counted at 11 plies. */
+static const uint64_t reference_leaves[4][PERFT_MAX_DEPTH] =
+{
+    {4, 12, 44, 128, 436, 1296, 3788, 9768, 22184, 41636, 60060},
+    {4, 12, 56, 244, 1364, 7604, 47740, 308716, 2115128, 0, 0},
+    {4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005320, 24571420, 212260880},
+    {4, 12, 56, 244, 1396, 8200, 55180, 392268, 3045812, 0, 0}
+};
+
+/* Number of subtrees per thread of a parallel count: a thread that finishes
+ * its subtrees first takes the ones left by the others. */
+static const size_t tasks_per_thread = 16;
+
+/* The subtrees shallower than this are counted faster than they are looked
+ * up in the hash table. */
+static const size_t hash_depth = 3;
+
+/* The count of a hash entry use the low bits of its data and the depth the
+ * 8 high bits. */
+#define DEPTH_SHIFT 56
+#define LEAVES_MASK ((UINT64_C (1) << DEPTH_SHIFT) - 1)
+
+
+/********************************* Structures *********************************/
+
+/* An entry of the perft hash table. As in the transposition table, the key
+ * is the hash of the position and the depth xor the data, so the threads
+ * read and write the entries without lock. */
+typedef struct
+{
+    _Atomic uint64_t key;
+    _Atomic uint64_t data;
+} perft_entry_t;
+
+/* The first entry keeps the deepest count, the second one the last count. */
+typedef struct
+{
+    _Alignas (32) perft_entry_t entries[2];
+} perft_bucket_t;
+
+/* Counts of the subtrees already seen, keyed by position and depth. */
+typedef struct
+{
+    perft_bucket_t *buckets;
+    size_t mask; /* Number of buckets - 1 (a power of 2). */
+} perft_hash_t;
+
+/* A subtree to count by one of the threads. */
+typedef struct
+{
+    board_t *board;
+    size_t depth;
+} perft_task_t;
+
+/* What the threads of a parallel count share. */
+typedef struct
+{
+    perft_task_t *tasks;
+    size_t count;
+    atomic_size_t next; /* Next task to take. */
+    perft_hash_t *hash;
+} perft_work_t;
+
+/* A helper thread of a parallel count. */
+typedef struct
+{
+    pthread_t thread;
+    perft_work_t *work;
+    uint64_t leaves;
+} perft_worker_t;
+
+
+/****************************** Internal tools *******************************/
+
+/* Seconds elapsed since 'start'. */
+static double
+elapsed (const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) +
+           (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/********************************* Hash table *********************************/
+
+/* Allocate a hash table that use at most 'megabytes' of memory
+ *   -> return NULL if 'megabytes' is 0 or the allocation failed. */
+static perft_hash_t *
+hash_alloc (const size_t megabytes)
+{
+    size_t count = 1;
+
+    while (count * 2 * sizeof (perft_bucket_t) <= megabytes * 1024 * 1024)
+    {
+        count *= 2;
+    }
+
+    perft_hash_t *hash = (megabytes > 0) ? malloc (sizeof (perft_hash_t)) :
+                                           NULL;
+
+    if (hash == NULL)
+    {
+        return NULL;
+    }
+
+    hash->buckets = aligned_alloc (sizeof (perft_bucket_t),
+                                   count * sizeof (perft_bucket_t));
+
+    if (hash->buckets == NULL)
+    {
+        free (hash);
+
+        return NULL;
+    }
+
+    memset (hash->buckets, 0, count * sizeof (perft_bucket_t));
+    hash->mask = count - 1;
+
+    return hash;
+}
+
+/* Free the memory allocated to 'hash'. */
+static void
+hash_free (perft_hash_t *hash)
+{
+    if (hash == NULL)
+    {
+        return;
+    }
+
+    free (hash->buckets);
+    free (hash);
+}
+
+/* Key of the subtree of 'board' at 'depth' plies (SplitMix64 finalizer). */
+static uint64_t
+hash_key (const board_t *board, const size_t depth)
+{
+    uint64_t z = board_hash (board) ^ (depth * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/* Look for the subtree of key 'key' and depth 'depth'
+ *   -> return true and fill 'leaves' if it is found. */
+static bool
+hash_probe (const perft_hash_t *hash, const uint64_t key, const size_t depth,
+            uint64_t *leaves)
+{
+    const perft_bucket_t *bucket = &hash->buckets[key & hash->mask];
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        const perft_entry_t *entry = &bucket->entries[i];
+        uint64_t data = atomic_load_explicit (&entry->data,
+                                              memory_order_relaxed);
+        uint64_t stored = atomic_load_explicit (&entry->key,
+                                                memory_order_relaxed);
+
+        if ((stored ^ data) == key && data >> DEPTH_SHIFT == depth)
+        {
+            *leaves = data & LEAVES_MASK;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Store the count 'leaves' of the subtree of key 'key' and depth 'depth'. */
+static void
+hash_store (perft_hash_t *hash, const uint64_t key, const size_t depth,
+            const uint64_t leaves)
+{
+    if (leaves > LEAVES_MASK)
+    {
+        return;
+    }
+
+    perft_bucket_t *bucket = &hash->buckets[key & hash->mask];
+    uint64_t deepest = atomic_load_explicit (&bucket->entries[0].data,
+                                             memory_order_relaxed);
+    perft_entry_t *entry = (depth >= deepest >> DEPTH_SHIFT) ?
+                           &bucket->entries[0] : &bucket->entries[1];
+    uint64_t data = leaves | (uint64_t) depth << DEPTH_SHIFT;
+
+    atomic_store_explicit (&entry->data, data, memory_order_relaxed);
+    atomic_store_explicit (&entry->key, key ^ data, memory_order_relaxed);
+}
+
+
+/****************************** Node counting *********************************/
+
+/* Count the leaves of 'board' at 'depth' plies with the counts of 'hash'
+ * (or without if it is NULL). */
+static uint64_t
+count_leaves (board_t *board, const size_t depth, perft_hash_t *hash)
+{
+    if (depth == 0 || board_player (board) == EMPTY_DISC)
+    {
+        return 1;
+    }
+
+    uint64_t key = 0;
+    uint64_t leaves = 0;
+
+    if (hash != NULL && depth >= hash_depth)
+    {
+        key = hash_key (board, depth);
+
+        if (hash_probe (hash, key, depth, &leaves))
+        {
+            return leaves;
+        }
+    }
+
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
+    while (move_iter_next (&iter, &move))
+    {
+        undo_t undo;
+
+        board_do_move (board, move, &undo);
+        leaves += (depth == 1) ? 1 : count_leaves (board, depth - 1, hash);
+        board_undo_move (board, &undo);
+    }
+
+    if (hash != NULL && depth >= hash_depth)
+    {
+        hash_store (hash, key, depth, leaves);
+    }
+
+    return leaves;
+}
+
+/* Copy in 'work' the positions 'ply' plies below 'board' as the subtrees to
+ * count at 'depth' plies. The finished games on the way are not subtrees:
+ * they are added to 'leaves'.
+ *   -> return false if a copy failed. */
+static bool
+collect_tasks (board_t *board, const size_t ply, const size_t depth,
+               perft_work_t *work, uint64_t *leaves)
+{
+    if (board_player (board) == EMPTY_DISC)
+    {
+        (*leaves)++;
+
+        return true;
+    }
+
+    if (ply == 0)
+    {
+        perft_task_t *task = &work->tasks[work->count];
+        task->board = board_copy (board);
+        task->depth = depth;
+        work->count++;
+
+        return task->board != NULL;
+    }
+
+    bool ok = true;
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
+    while (ok && move_iter_next (&iter, &move))
+    {
+        undo_t undo;
+
+        board_do_move (board, move, &undo);
+        ok = collect_tasks (board, ply - 1, depth, work, leaves);
+        board_undo_move (board, &undo);
+    }
+
+    return ok;
+}
+
+/* Count the leaves of the tasks of 'work' until there is none left. */
+static uint64_t
+count_tasks (perft_work_t *work)
+{
+    uint64_t leaves = 0;
+    size_t i;
+
+    while ((i = atomic_fetch_add (&work->next, 1)) < work->count)
+    {
+        leaves += count_leaves (work->tasks[i].board, work->tasks[i].depth,
+                                work->hash);
+    }
+
+    return leaves;
+}
+
+/* Body of a helper thread of a parallel count. */
+static void *
+perft_worker (void *worker)
+{
+    perft_worker_t *self = worker;
+    self->leaves = count_tasks (self->work);
+
+    return NULL;
+}
+
+/* Count the leaves of 'board' at 'depth' plies with 'threads' threads: the
+ * tree is cut at the first ply with enough subtrees for all the threads and
+ * each thread counts the next subtree left. */
+static uint64_t
+parallel_perft (board_t *board, const size_t depth, const size_t threads,
+                perft_hash_t *hash)
+{
+    size_t ply = 0;
+    uint64_t nodes = 1;
+
+    while (threads > 1 && ply < depth && nodes < threads * tasks_per_thread)
+    {
+        ply++;
+        nodes = perft (board, ply);
+    }
+
+    perft_work_t work = {.count = 0, .next = 0, .hash = hash};
+    work.tasks = (ply > 0) ? malloc (nodes * sizeof (perft_task_t)) : NULL;
+    uint64_t leaves = 0;
+
+    if (work.tasks == NULL ||
+        !collect_tasks (board, ply, depth - ply, &work, &leaves))
+    {
+        for (size_t i = 0; i < work.count; i++)
+        {
+            board_free (work.tasks[i].board);
+        }
+
+        free (work.tasks);
+
+        return count_leaves (board, depth, hash);
+    }
+
+    perft_worker_t *workers = malloc ((threads - 1) * sizeof (perft_worker_t));
+    size_t started = 0;
+
+    while (workers != NULL && started < threads - 1)
+    {
+        workers[started].work = &work;
+
+        if (pthread_create (&workers[started].thread, NULL, perft_worker,
+                            &workers[started]) != 0)
+        {
+            break;
+        }
+
+        started++;
+    }
+
+    leaves += count_tasks (&work);
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join (workers[i].thread, NULL);
+        leaves += workers[i].leaves;
+    }
+
+    for (size_t i = 0; i < work.count; i++)
+    {
+        board_free (work.tasks[i].board);
+    }
+
+    free (workers);
+    free (work.tasks);
+
+    return leaves;
+}
+
+uint64_t
+perft (board_t *board, const size_t depth)
+{
+    return count_leaves (board, depth, NULL);
+}
+
+bool
+perft_reference (const size_t size, const size_t depth, uint64_t *leaves)
+{
+    if (size < 4 || size > 10 || size % 2 != 0 ||
+        depth == 0 || depth > PERFT_MAX_DEPTH)
+    {
+        return false;
+    }
+
+    *leaves = reference_leaves[size / 2 - 2][depth - 1];
+
+    return *leaves != 0;
+}
+
+bool
+perft_run (board_t *board, const size_t depth, const size_t threads,
+           const size_t megabytes, FILE *fd)
+{
+    bool ok = true;
+    perft_hash_t *hash = hash_alloc (megabytes);
+    board_t *start = board_init (board_size (board));
+    bool is_start = start != NULL && board_hash (start) == board_hash (board);
+    uint64_t total = 0;
+    double total_time = 0;
+
+    board_free (start);
+    fprintf (fd, "perft with %zu thread%s and %s hash table\n", threads,
+             (threads > 1) ? "s" : "", (hash != NULL) ? "a" : "no");
+
+    for (size_t d = 1; d <= depth; d++)
+    {
+        struct timespec begin;
+        clock_gettime (CLOCK_MONOTONIC, &begin);
+
+        uint64_t leaves = parallel_perft (board, d, threads, hash);
+        double seconds = elapsed (&begin);
+        uint64_t expected;
+
+        total += leaves;
+        total_time += seconds;
+        fprintf (fd, "perft %2zu: %14llu leaves %10.3f s %14.0f nodes/s",
+                 d, (unsigned long long) leaves, seconds,
+                 (seconds > 0) ? leaves / seconds : 0.0);
+
+        if (is_start && perft_reference (board_size (board), d, &expected))
+        {
+            fprintf (fd, (leaves == expected) ? "  ok\n" : "  MISMATCH\n");
+            ok = ok && leaves == expected;
+        }
+        else
+        {
+            fprintf (fd, "\n");
+        }
+    }
+
+    fprintf (fd, "total: %15llu leaves %10.3f s %14.0f nodes/s\n",
+             (unsigned long long) total, total_time,
+             (total_time > 0) ? total / total_time : 0.0);
+    hash_free (hash);
+
+    return ok;
+}
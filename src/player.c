@@ -1,58 +1,220 @@
 #define _POSIX_C_SOURCE 200809L /* To use getline (). */
 
 #include <player.h>
+#include <book.h>
+#include <endgame.h>
+#include <tt.h>
 
 #include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <string.h>
 
 
 /********************************* Structures *********************************/
 
-/* Alpha / Beta structure to store the state of both values. */
+/* Maximal number of plies of a search (a pass cost a ply). */
+#define MAX_PLY (2 * MAX_BOARD_SIZE * MAX_BOARD_SIZE + 2)
+
+/* Split point and threads of a parallel search (see below). */
+typedef struct split_t split_t;
+typedef struct pool_t pool_t;
+
+/* State of a search: each thread of a search has its own one. */
 typedef struct
 {
-    int alpha;
+    size_t depth_ini;   /* Depth of the root search. */
+    bool verbose;       /* Print the progress of the search. */
+    bool rng_is_init;
+    unsigned int seed;  /* State of the rng (rand_r ()). */
+    size_t calls;       /* Calls of search_timeout (). */
+    size_t threads;     /* Threads of the search. */
+    pool_t *pool;       /* Threads of the running search (NULL if alone). */
+    size_t id;          /* Index of the thread in the pool. */
+    split_t *split;     /* Split point the thread works for (NULL if none). */
+    /* Two killer moves (last moves that made a cut) for each ply. */
+    move_t killers[MAX_PLY][2];
+    /* History of the cuts made by each square for each player. */
+    int history[2][MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    search_stats_t stats; /* Statistics of the thread in the search. */
+    int value;          /* Value of the best move of the last root search. */
+} search_t;
+
+/* Policy of a tactic in the negamax search: near the root, it can decide the
+ * value of a node without searching it. */
+typedef struct
+{
+    /* Give the value (for the player to move) of 'board', searched to 'depth'
+     * by the AI 'player_init'
+     *   -> return true if the node is decided. */
+    bool (*node_value) (const search_t *search, const board_t *board,
+                        const size_t depth, const disc_t player_init,
+                        int *value);
+    /* The nodes at most 'near_root' plies under the root (depth_ini - depth)
+     * are given to node_value and don't use the transposition table. */
+    size_t near_root;
+} search_policy_t;
+
+/* A move with its score for the move ordering. */
+typedef struct
+{
+    move_t move;
+    int score;
+} scored_move_t;
+
+/* A split point of the parallel search (Young Brothers Wait): a node whose
+ * first move is searched, and whose other moves are shared by the thread
+ * that owns it and the threads that steal them. */
+struct split_t
+{
+    split_t *parent;            /* Split point of the owner (NULL if none). */
+    board_t *board;             /* Copy of the node for the other threads. */
+    scored_move_t moves[MAX_BOARD_SIZE * MAX_BOARD_SIZE]; /* Search order. */
+    size_t count;
+    size_t depth;
     int beta;
-} alpha_beta_t;
+    disc_t player_init;
+    const search_policy_t *policy;
+    /* The root keeps the first of the best moves in the order (as a single
+     * thread), whichever thread find it first. */
+    bool root;
+    pthread_mutex_t lock;       /* Lock of the fields below. */
+    size_t next;                /* First move not taken by a thread. */
+    size_t done;                /* Number of moves searched. */
+    size_t workers;             /* Threads working on it but the owner. */
+    int alpha;
+    int best_value;
+    size_t best;                /* Index of the best move (count if none). */
+    atomic_bool cut;            /* A move made a cut: the search stops. */
+};
+
+/* Work-stealing deque of the split points of a thread: the thread pushes and
+ * pops its split points at the end, the other threads steal the oldest ones
+ * (the biggest subtrees). */
+typedef struct
+{
+    split_t *splits[MAX_PLY];
+    size_t count;
+    pthread_mutex_t lock;
+} deque_t;
+
+/* Threads of a parallel search: the main one and its helpers. */
+struct pool_t
+{
+    size_t count;               /* Number of threads (and of deques). */
+    size_t started;             /* Number of helpers started. */
+    deque_t *deques;            /* Deque of each thread. */
+    atomic_bool finished;       /* The search is over: the helpers stop. */
+};
+
+/* A helper thread of a parallel search, with its own search. */
+typedef struct
+{
+    pthread_t thread;
+    search_t search;
+} helper_t;
+
+/* A helper thread of a Lazy SMP search: it deepens its own search of the
+ * root from 'first_depth', only to fill the shared transposition table. */
+typedef struct
+{
+    pthread_t thread;
+    short ai;                /* Root search used. */
+    size_t first_depth;
+    board_t *board;
+    search_t search;
+    move_t best_move;        /* Best move of the deepest completed depth. */
+    size_t depth_reached;
+} lazy_helper_t;
 
 
 /*************************** Function declarations ****************************/
 
-static int min (board_t *board, const size_t depth, const disc_t player_init);
+static int min (search_t *search, board_t *board, const size_t depth,
+                const disc_t player_init);
+
+static int negamax (search_t *search, board_t *board, const size_t depth,
+                    int alpha, const int beta, const disc_t player_init,
+                    const search_policy_t *policy);
 
-static alpha_beta_t ab_min (board_t *board, const size_t depth,
-                            const alpha_beta_t a_b, const disc_t player_init);
+static move_t ab_main_loop (search_t *search, board_t *board,
+                            const bitboard_t moves, move_t best_move,
+                            const search_policy_t *policy);
 
-static alpha_beta_t newton_min (board_t *board, const size_t depth,
-                                const alpha_beta_t a_b,
-                                const disc_t player_init);
+static move_t minimax_root (search_t *search, board_t *board,
+                            move_t best_move);
 
-static alpha_beta_t ab_max (board_t *board, const size_t depth,
-                            const alpha_beta_t a_b, const disc_t player_init);
+static move_t ab_root (search_t *search, board_t *board, move_t best_move);
 
-static alpha_beta_t newton_max (board_t *board, const size_t depth,
-                                const alpha_beta_t a_b,
-                                const disc_t player_init);
+static move_t newton_root (search_t *search, board_t *board, move_t best_move);
 
-static move_t ab_main_loop (const short ai, board_t *board, move_t best_move);
+static move_t iterative_deepening (search_t *search, const short ai,
+                                   board_t *board, move_t best_move);
+
+static int split_search (search_t *search, board_t *board,
+                         const scored_move_t *moves, const size_t count,
+                         const size_t depth, const int alpha, const int beta,
+                         const int best_value, const disc_t player_init,
+                         const search_policy_t *policy, const bool root,
+                         move_t *best_move);
 
 
 /********************************* Constants **********************************/
 
-static bool rng_is_init = false;
-static bool verbose = false;
 static const int infinity = MAX_BOARD_SIZE * MAX_BOARD_SIZE * 3;
-static size_t depth_ini = 0;
-
-/* Function pointer of ab_min used. */
-static alpha_beta_t (*ab_min_used[2]) (board_t *, const size_t,
-                                       const alpha_beta_t, const disc_t) =
-{ab_min, newton_min};
 
-/* Function pointer of ab_max used. */
-static alpha_beta_t (*ab_max_used[2]) (board_t *, const size_t,
-                                       const alpha_beta_t, const disc_t) =
-{ab_max, newton_max};
+/* Search of the main thread (the other threads start from a copy of it). */
+static search_t main_search = {.threads = 1};
+
+/* Transposition table of the alpha / beta searches and its size. */
+static tt_t *tt = NULL;
+static size_t hash_megabytes = 16;
+/* Lock of the allocation of the table by the threads of newton_value (). */
+static pthread_mutex_t tt_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Time budget of a move in seconds (0 => search at the fixed depth_ini). */
+static double time_per_move = 0;
+/* Instant when the search must stop and true once it is reached. */
+static struct timespec deadline;
+static atomic_bool time_out = false;
+
+/* Number of empties under which the alpha / beta AIs play perfectly with the
+ * endgame solver. */
+static size_t endgame_empties = 14;
+
+/* Opening book played by the alpha / beta AIs before any search (NULL if
+ * none). */
+static book_t *book = NULL;
+
+/* Print the statistics of each search as a JSON line and the statistics of
+ * the last search. */
+static bool stats_json = false;
+static search_stats_t last_stats;
+
+/* Scores of the move ordering: the move of the transposition table first,
+ * then the killers, then the other moves by their square (corners first,
+ * X-squares last), their history and the mobility left to the opponent
+ * (fastest-first, only for the nodes of at least 'order_mobility_depth'). */
+static const int order_tt_move = 1 << 30;
+static const int order_killer[2] = {1 << 25, 1 << 24};
+static const int order_corner = 4096;
+static const int order_x_square = -4096;
+static const int order_c_square = -1024;
+static const int order_edge = 512;
+static const int order_mobility = 256;
+static const int history_max = 4096;
+static const size_t order_mobility_depth = 3;
+
+/* Minimal depth of a node to share its moves between the threads (the
+ * smaller ones are not worth it). */
+static const size_t split_depth = 4;
+
+/* Function pointer of the root search (to depth_ini) used and its name. */
+static move_t (*root_search_used[3]) (search_t *, board_t *, move_t) =
+{minimax_root, ab_root, newton_root};
+static const char *root_search_names[3] = {"minimax", "alpha/beta", "newton"};
 
 
 /***************************** Intern management ******************************/
@@ -60,18 +222,316 @@ static alpha_beta_t (*ab_max_used[2]) (board_t *, const size_t,
 void
 set_verbose (void)
 {
-    verbose = true;
+    main_search.verbose = true;
+}
+
+void
+set_hash_size (const size_t megabytes)
+{
+    if (megabytes != hash_megabytes)
+    {
+        tt_free (tt);
+        tt = NULL;
+        hash_megabytes = megabytes;
+    }
+}
+
+void
+set_time_per_move (const double seconds)
+{
+    time_per_move = seconds;
+}
+
+void
+set_threads (const size_t count)
+{
+    main_search.threads = (count == 0) ? 1 : count;
+}
+
+void
+set_stats (void)
+{
+    stats_json = true;
+}
+
+search_stats_t
+get_search_stats (void)
+{
+    return last_stats;
+}
+
+void
+set_endgame_empties (const size_t empties)
+{
+    endgame_empties = empties;
+}
+
+bool
+set_book (const char *filename)
+{
+    book_t *new_book = book_open (filename);
+
+    if (new_book == NULL)
+    {
+        return false;
+    }
+
+    book_close (book);
+    book = new_book;
+
+    return true;
+}
+
+/* Seconds elapsed from 'start' to now. */
+static double
+elapsed_since (const struct timespec start)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* Tell if the time of the search is over. The clock is only read every 1024
+ * calls of each thread (in each node of the searches). */
+static bool
+search_timeout (search_t *search)
+{
+    if (time_per_move <= 0 || time_out)
+    {
+        return time_out;
+    }
+
+    if ((++search->calls & 1023) == 0 && elapsed_since (deadline) >= 0)
+    {
+        time_out = true;
+    }
+
+    return time_out;
+}
+
+/* Tell if a split point that the thread works for is cut (its search is then
+ * useless). */
+static bool
+split_aborted (const search_t *search)
+{
+    for (const split_t *split = search->split; split != NULL;
+         split = split->parent)
+    {
+        if (split->cut)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Number of empty squares of 'board'. */
+static size_t
+count_empties (const board_t *board)
+{
+    size_t size = board_size (board);
+    score_t score = board_score (board);
+
+    return size * size - score.black - score.white;
+}
+
+/* Forget the killers of 'search' and age its history. */
+static void
+search_reset (search_t *search)
+{
+    for (size_t i = 0; i < MAX_PLY; i++)
+    {
+        search->killers[i][0] = search->killers[i][1] =
+            (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
+    }
+
+    for (size_t i = 0; i < MAX_BOARD_SIZE * MAX_BOARD_SIZE; i++)
+    {
+        search->history[0][i] /= 2;
+        search->history[1][i] /= 2;
+    }
+}
+
+/* Start a new search: allocate the transposition table at the first search
+ * (if it is not disabled), start a new search in it, forget the killers and
+ * age the history. */
+static void
+search_init (search_t *search)
+{
+    if (tt == NULL && hash_megabytes > 0)
+    {
+        tt = tt_alloc (hash_megabytes);
+    }
+
+    tt_new_search (tt);
+    search_reset (search);
+}
+
+/* Start the statistics of a new search of 'search' and store the instant of
+ * its start in 'start'. */
+static void
+stats_start (search_t *search, struct timespec *start)
+{
+    memset (&search->stats, 0, sizeof (search_stats_t));
+    clock_gettime (CLOCK_MONOTONIC, start);
+}
+
+/* Add the statistics 'from' of a helper thread to 'to'. */
+static void
+stats_add (search_stats_t *to, const search_stats_t *from)
+{
+    to->nodes += from->nodes;
+    to->evaluations += from->evaluations;
+    to->tt_probes += from->tt_probes;
+    to->tt_hits += from->tt_hits;
+
+    for (size_t i = 0; i < STATS_CUTOFFS; i++)
+    {
+        to->cutoffs[i] += from->cutoffs[i];
+    }
+}
+
+/* Count in the statistics of 'search' a cut made by the i-th move searched
+ * in a node (the last counter keeps the cuts of all the later moves). */
+static void
+stats_cutoff (search_t *search, const size_t i)
+{
+    search->stats.cutoffs[(i < STATS_CUTOFFS) ? i : STATS_CUTOFFS - 1]++;
+}
+
+/* Finish the statistics of the search 'name' of 'search' started at 'start'
+ * that reached 'depth' (with the ones of its helpers already added): keep
+ * them for get_search_stats (), print them in verbose mode and as a JSON
+ * line if asked. */
+static void
+stats_report (search_t *search, const char *name, const size_t depth,
+              const struct timespec start)
+{
+    search_stats_t *stats = &search->stats;
+    stats->search = name;
+    stats->depth = depth;
+    stats->seconds = elapsed_since (start);
+    last_stats = *stats;
+
+    /* Nodes = branching_factor ^ depth. */
+    double branching = (depth > 0 && stats->nodes > 0) ?
+                       pow ((double) stats->nodes, 1.0 / depth) : 0;
+    double nps = (stats->seconds > 0) ? stats->nodes / stats->seconds : 0;
+
+    if (search->verbose)
+    {
+        printf ("Search: depth %zu, %zu nodes, %zu evaluations in %.3f s "
+                "(%.0f nodes/s).\nBranching factor %.2f, %zu hits of %zu "
+                "TT probes, cutoffs by move:", depth, stats->nodes,
+                stats->evaluations, stats->seconds, nps, branching,
+                stats->tt_hits, stats->tt_probes);
+
+        for (size_t i = 0; i < STATS_CUTOFFS; i++)
+        {
+            printf (" %zu", stats->cutoffs[i]);
+        }
+
+        printf (".\n");
+    }
+
+    if (stats_json)
+    {
+        printf ("{\"search\": \"%s\", \"depth\": %zu, \"nodes\": %zu, "
+                "\"evaluations\": %zu, \"cutoffs\": [", name, depth,
+                stats->nodes, stats->evaluations);
+
+        for (size_t i = 0; i < STATS_CUTOFFS; i++)
+        {
+            printf ("%s%zu", (i > 0) ? ", " : "", stats->cutoffs[i]);
+        }
+
+        printf ("], \"tt_probes\": %zu, \"tt_hits\": %zu, "
+                "\"branching_factor\": %.3f, \"seconds\": %.6f, "
+                "\"nps\": %.0f}\n", stats->tt_probes, stats->tt_hits,
+                branching, stats->seconds, nps);
+    }
+}
+
+/* Look in the transposition table if a previous search of 'board' to 'depth'
+ * at least decide the node with the window ['alpha', 'beta'], and store the
+ * best move of the previous search in 'move' (MAX_BOARD_SIZE row and column
+ * if there is none)
+ *   -> return true and store the value in 'value' if so. */
+static bool
+tt_cutoff (search_t *search, const board_t *board, const size_t depth,
+           const int alpha, const int beta, int *value, move_t *move)
+{
+    tt_data_t data;
+    *move = (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
+
+    if (tt == NULL)
+    {
+        return false;
+    }
+
+    search->stats.tt_probes++;
+
+    if (!tt_probe (tt, board_hash (board), &data))
+    {
+        return false;
+    }
+
+    search->stats.tt_hits++;
+
+    *move = data.move;
+
+    if (data.depth < depth)
+    {
+        return false;
+    }
+
+    if (data.bound == TT_EXACT ||
+        (data.bound == TT_LOWER && data.score >= beta) ||
+        (data.bound == TT_UPPER && data.score <= alpha))
+    {
+        *value = data.score;
+
+        return true;
+    }
+
+    return false;
+}
+
+/* Store in the transposition table the 'value' found by the search of 'board'
+ * to 'depth' with the window ['alpha', 'beta']. */
+static void
+tt_save (const board_t *board, const size_t depth, const int alpha,
+         const int beta, const int value, const move_t best_move)
+{
+    /* An interrupted search has no meaningful value. */
+    if (tt == NULL || time_out)
+    {
+        return;
+    }
+
+    /* Out of the window, the value is just a bound. */
+    tt_bound_t bound = (value <= alpha) ? TT_UPPER :
+                       (value >= beta) ? TT_LOWER : TT_EXACT;
+
+    tt_store (tt, board_hash (board),
+              &(tt_data_t) {.score = value,
+                            .depth = depth,
+                            .bound = bound,
+                            .move = best_move});
 }
 
-/* Initiate the rng with the time and the number of enter process.  */
+/* Initiate the rng of 'search' with the time and the number of enter
+ * process. */
 static void
-prng_init (void)
+prng_init (search_t *search)
 {
-    if (!rng_is_init)
+    if (!search->rng_is_init)
     {
         /* Take times and processor number as initial value. */
-        srand (time (NULL) - getpid ());
-        rng_is_init = true;
+        search->seed = time (NULL) - getpid ();
+        search->rng_is_init = true;
     }
 }
 
@@ -282,6 +742,16 @@ score_heuristic (const board_t *board, const disc_t player_init)
     return final_score;
 }
 
+/* score_heuristic () of a leaf of the search 'search' (counted in its
+ * statistics). */
+static int
+evaluate (search_t *search, const board_t *board, const disc_t player_init)
+{
+    search->stats.evaluations++;
+
+    return score_heuristic (board, player_init);
+}
+
 
 /********************************* Heuristics *********************************/
 
@@ -290,6 +760,8 @@ score_heuristic (const board_t *board, const disc_t player_init)
 move_t
 human_player (board_t *board)
 {
+    search_t *search = &main_search;
+
     if (board == NULL)
     {
         return (move_t) {.row = MAX_BOARD_SIZE + 1,
@@ -458,7 +930,7 @@ human_player (board_t *board)
 
         free (move_chooses);
 
-        if (verbose)
+        if (search->verbose)
         {
             print_move_verbose (move, board_player (board), 0);
         }
@@ -472,25 +944,29 @@ human_player (board_t *board)
 move_t
 random_player (board_t *board)
 {
+    search_t *search = &main_search;
+
     if (board == NULL)
     {
         return (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
     }
 
     /* Initiate the seed of the rng if it's not. */
-    prng_init ();
+    prng_init (search);
     /* Compute a random number modulo the number of possible player moves. */
-    size_t cpt_rand = rand () % board_count_player_moves (board);
+    size_t cpt_rand = rand_r (&search->seed) % board_count_player_moves (board);
     /* Get the 'cpt_rand' next move. */
-    move_t player_move = board_next_move (board);
+    move_iter_t iter = move_iter_init (board);
+    move_t player_move;
+    move_iter_next (&iter, &player_move);
 
     while (cpt_rand != 0)
     {
-        player_move = board_next_move (board);
+        move_iter_next (&iter, &player_move);
         cpt_rand--;
     }
 
-    if (verbose)
+    if (search->verbose)
     {
         print_move_verbose (player_move, board_player (board), 1);
     }
@@ -502,7 +978,8 @@ random_player (board_t *board)
 
 /* Return the max score of childrens next moves. */
 static int
-max (board_t *board, const size_t depth, const disc_t player_init)
+max (search_t *search, board_t *board, const size_t depth,
+     const disc_t player_init)
 {
     if (board == NULL)
     {
@@ -510,12 +987,20 @@ max (board_t *board, const size_t depth, const disc_t player_init)
         return infinity;
     }
 
+    /* The result of an interrupted search is not used. */
+    if (search_timeout (search))
+    {
+        return 0;
+    }
+
+    search->stats.nodes++;
+
     disc_t actual_player = board_player (board);
 
     /* Test of the position of the depth. */
     if (depth == (size_t) 0 || actual_player == EMPTY_DISC)
     {
-        return score_heuristic (board, player_init);
+        return evaluate (search, board, player_init);
     }
 
     /* Initiate the max_score and the intermediate value_score as -(size * size)
@@ -523,33 +1008,29 @@ max (board_t *board, const size_t depth, const disc_t player_init)
     int max_value = -(board_size (board) * board_size (board));
     int value = -(board_size (board) * board_size (board));
 
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
     /* On all possible moves of this min node. */
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    while (move_iter_next (&iter, &move))
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
-
-        if (copy == NULL)
-        {
-            return -infinity;
-        }
+        undo_t undo;
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+        /* Play the next i-th possible moves on the board. */
+        board_do_move (board, move, &undo);
 
-        if (board_player (copy) == EMPTY_DISC)
+        if (board_player (board) == EMPTY_DISC)
         {
-            value = score_heuristic (copy, player_init);
+            value = evaluate (search, board, player_init);
         }
-        else if (board_player (copy) == actual_player)
+        else if (board_player (board) == actual_player)
         {
-            value = max (copy, (depth <= 2) ? 0 : depth - 2, player_init);
+            value = max (search, board, (depth <= 2) ? 0 : depth - 2,
+                         player_init);
         }
         else
         {
-            value = -min (copy, depth - 1, player_init);
+            value = -min (search, board, depth - 1, player_init);
         }
 
         /* Make the score_heuristic to weight the knot. */
@@ -558,7 +1039,7 @@ max (board_t *board, const size_t depth, const disc_t player_init)
             max_value = value;
         }
 
-        board_free (copy);
+        board_undo_move (board, &undo);
     }
 
     return max_value;
@@ -566,7 +1047,8 @@ max (board_t *board, const size_t depth, const disc_t player_init)
 
 /* Return the min score of childrens next moves. */
 static int
-min (board_t *board, const size_t depth, const disc_t player_init)
+min (search_t *search, board_t *board, const size_t depth,
+     const disc_t player_init)
 {
     if (board == NULL)
     {
@@ -574,12 +1056,20 @@ min (board_t *board, const size_t depth, const disc_t player_init)
         return -infinity;
     }
 
+    /* The result of an interrupted search is not used. */
+    if (search_timeout (search))
+    {
+        return 0;
+    }
+
+    search->stats.nodes++;
+
     disc_t opponent = board_player (board);
 
     /* Test of the position of the depth. */
     if (depth == (size_t) 0 || opponent == EMPTY_DISC)
     {
-        return -score_heuristic (board, player_init);
+        return -evaluate (search, board, player_init);
     }
 
     /* Initiate the min_score and the intermediate value score as (size * size)
@@ -587,36 +1077,32 @@ min (board_t *board, const size_t depth, const disc_t player_init)
     int min_value = (board_size (board) * board_size (board));
     int value = (board_size (board) * board_size (board));
 
+    move_iter_t iter = move_iter_init (board);
+    move_t move;
+
     /* For all possible moves we take the minimum of score_heuristic. */
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    while (move_iter_next (&iter, &move))
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
-
-        if (copy == NULL)
-        {
-            return infinity;
-        }
+        undo_t undo;
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+        /* Play the next i-th possible moves on the board. */
+        board_do_move (board, move, &undo);
 
         /* If game is over. */
-        if (board_player (copy) == EMPTY_DISC)
+        if (board_player (board) == EMPTY_DISC)
         {
-            value = -score_heuristic (copy, player_init);
+            value = -evaluate (search, board, player_init);
         }
         /* If opponent's turn. */
-        else if (board_player (copy) == opponent)
+        else if (board_player (board) == opponent)
         {
-            value = min (copy, (depth <= 2) ? 0 : depth - 2, player_init);
+            value = min (search, board, (depth <= 2) ? 0 : depth - 2,
+                         player_init);
         }
         /* Else player's turn. */
         else
         {
-            value = -max (copy, depth - 1, player_init);
+            value = -max (search, board, depth - 1, player_init);
         }
 
         /* Make the score_heuristic to weight the knot. */
@@ -625,15 +1111,79 @@ min (board_t *board, const size_t depth, const disc_t player_init)
             min_value = value;
         }
 
-        board_free (copy);
+        board_undo_move (board, &undo);
     }
 
     return min_value;
 }
 
+/* Root of the minimax search (to depth_ini): return one of the best moves
+ * or 'best_move' if there is none. */
+static move_t
+minimax_root (search_t *search, board_t *board, move_t best_move)
+{
+    disc_t player_init = board_player (board);
+    /* Initiate the best score as - infinity. */
+    int best_value = -infinity;
+    int value = best_value;
+    size_t count = 0;
+    move_iter_t iter = move_iter_init (board);
+    /* The moves symmetric to another one are not searched. */
+    iter.moves = board_unique_moves (board, iter.moves);
+    size_t number_max_moves = bitboard_popcount (iter.moves);
+    move_t possible_moves[number_max_moves];
+    int cpt_move = 0;
+    move_t move;
+
+    while (move_iter_next (&iter, &move))
+    {
+        undo_t undo;
+
+        /* Play the next i-th possible moves. */
+        board_do_move (board, move, &undo);
+        /* Minimisation of the score of opponent. */
+        value = -min (search, board, search->depth_ini, player_init);
+
+        /* Compare with the actual best_value to maximise it. */
+        if (value > best_value)
+        {
+            best_value = value;
+            cpt_move = 1;
+            possible_moves[0] = move;
+        }
+        else if (value == best_value)
+        {
+            possible_moves[cpt_move++] = move;
+        }
+
+        board_undo_move (board, &undo);
+
+        /* To print the progress barre on the consol. */
+        if (search->verbose)
+        {
+            count++;
+            print_progress (count, number_max_moves, player_init);
+        }
+    }
+
+    if (cpt_move == 0)
+    {
+        return best_move;
+    }
+
+    prng_init (search);
+
+    return possible_moves[rand_r (&search->seed) % cpt_move];
+}
+
 move_t
 minimax_player (board_t *board)
 {
+    search_t *search = &main_search;
+
+    /* No statistics until a search is done. */
+    memset (&last_stats, 0, sizeof (search_stats_t));
+
     if (board == NULL)
     {
         return (move_t) {.row = MAX_BOARD_SIZE + 1,
@@ -643,45 +1193,40 @@ minimax_player (board_t *board)
     switch (board_size (board))
     {
         case 4 :
-            depth_ini = 8;
+            search->depth_ini = 8;
 
             break;
 
         case 6 :
-            depth_ini = 5;
+            search->depth_ini = 5;
 
             break;
 
         case 8 :
-            depth_ini = 4;
+            search->depth_ini = 4;
 
             break;
 
         default :
-            depth_ini = 3;
+            search->depth_ini = 3;
     }
 
     disc_t player_init = board_player (board);
 
-    if (verbose)
+    if (search->verbose)
     {
         printf ("Wait the AI '%c' compute:\n", player_init);
     }
 
-    /* Initiate the best score as - infinity. */
-    int best_value = -infinity;
-    int value = best_value;
-    /* Declaration of the final return best move. */
+    /* Declaration of the final return best move (the first by default). */
     move_t best_move;
-    size_t count = 0;
-    size_t number_max_moves = board_count_player_moves (board);
+    move_iter_t iter = move_iter_init (board);
+    move_iter_next (&iter, &best_move);
 
     /* If just one possible move, do it. */
-    if (number_max_moves == 1)
+    if (board_count_player_moves (board) == 1)
     {
-        best_move = board_next_move (board);
-
-        if (verbose)
+        if (search->verbose)
         {
             printf ("\033[A\33[2K");
         }
@@ -690,55 +1235,10 @@ minimax_player (board_t *board)
      * and make the best. */
     else
     {
-        move_t possible_moves[number_max_moves];
-        int cpt_move = 0;
-
-        for (size_t i = 0; i < number_max_moves; i++)
-        {
-            /* Take a possible move. */
-            move_t move = board_next_move (board);
-            /* Copy the actual board. */
-            board_t *copy = board_copy (board);
-
-            if (copy == NULL)
-            {
-                board_free (copy);
-                return (move_t) {.row = MAX_BOARD_SIZE + 1,
-                                 .column = MAX_BOARD_SIZE + 1};
-            }
-
-            /* Play the next i-th possible moves. */
-            board_play (copy, move);
-            /* Minimisation of the score of opponent. */
-            value = -min (copy, depth_ini, player_init);
-
-            /* Compare with the actual best_value to maximise it. */
-            if (value > best_value)
-            {
-                best_value = value;
-                cpt_move = 1;
-                possible_moves[0] = move;
-            }
-            else if (value == best_value)
-            {
-                possible_moves[cpt_move++] = move;
-            }
-
-            board_free (copy);
-
-            /* To print the progress barre on the consol. */
-            if (verbose)
-            {
-                count++;
-                print_progress (count, number_max_moves, player_init);
-            }
-        }
-
-        prng_init ();
-        best_move = possible_moves[rand () % cpt_move];
+        best_move = iterative_deepening (search, 0, board, best_move);
     }
 
-    if (verbose)
+    if (search->verbose)
     {
         print_move_verbose (best_move, player_init, 2);
     }
@@ -746,200 +1246,393 @@ minimax_player (board_t *board)
     return best_move;
 }
 
-/* ------------------------------ Alpha / Beta ------------------------------ */
+/* ----------------------------- Move ordering ------------------------------ */
 
-/* Calculate the alpha and beta for a max node. */
-static alpha_beta_t
-ab_max (board_t *board, const size_t depth, const alpha_beta_t a_b,
-        const disc_t player_init)
+/* Tell if the moves 'a' and 'b' are the same. */
+static bool
+same_move (const move_t a, const move_t b)
 {
-    if (board == NULL)
-    {
-        return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        /* Only in C11 version. */
-    }
+    return a.row == b.row && a.column == b.column;
+}
 
-    /* The player is opponent in ab_min. */
-    disc_t player = board_player (board);
-    /* Tampon alpha beta initiate at alpha and beta value to enter. */
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
+/* Static priority of the square of 'move' on a board of size 'size'. */
+static int
+square_priority (const size_t size, const move_t move)
+{
+    bool row_edge = move.row == 0 || move.row == size - 1;
+    bool column_edge = move.column == 0 || move.column == size - 1;
+    bool row_next = move.row == 1 || move.row == size - 2;
+    bool column_next = move.column == 1 || move.column == size - 2;
 
-    /* Test if depth == 0 or game is over. */
-    if (depth == (size_t) 0)
+    if (row_edge && column_edge)
     {
-        tampon_ab.alpha = score_heuristic (board, player_init);
-
-        if (tampon_ab.alpha > result_ab.alpha)
-        {
-            result_ab.alpha = tampon_ab.alpha;
-        }
-
-        return result_ab;
+        return order_corner;
     }
 
-    /* For all possible moves we take the minimum of score_heuristic. */
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    /* Diagonal neighbour of a corner. */
+    if (row_next && column_next)
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+        return order_x_square;
+    }
 
-        if (copy == NULL)
-        {
-            board_free (copy);
-            return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        }
+    /* Neighbour of a corner on a border. */
+    if ((row_edge && column_next) || (column_edge && row_next))
+    {
+        return order_c_square;
+    }
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+    return (row_edge || column_edge) ? order_edge : 0;
+}
 
-        /* If game is over. */
-        if (board_player (copy) == EMPTY_DISC)
-        {
-            /* Alpha take the maximum value between score and alpha. */
-            tampon_ab.beta = score_heuristic (copy, player_init);
+/* Fill 'moves' with the possible moves of 'board' that are in 'subset' and
+ * their score for a search to 'depth' ('tt_move' is the move of the
+ * transposition table)
+ *   -> return the number of moves. */
+static size_t
+order_moves (search_t *search, board_t *board, const bitboard_t subset,
+             const size_t depth, const move_t tt_move, scored_move_t *moves)
+{
+    size_t size = board_size (board);
+    disc_t player = board_player (board);
+    size_t ply = search->depth_ini + 1 - depth;
+    int *player_history = search->history[(player == BLACK_DISC) ? 0 : 1];
+    move_iter_t iter = move_iter_init (board);
+    iter.moves &= subset;
+    size_t count = 0;
+    move_t move;
 
-            if (tampon_ab.beta > result_ab.alpha)
-            {
-                result_ab.alpha = tampon_ab.beta;
-            }
+    while (move_iter_next (&iter, &move))
+    {
+        int score;
+
+        if (same_move (move, tt_move))
+        {
+            score = order_tt_move;
         }
-        else if (board_player (copy) == player)
+        else if (same_move (move, search->killers[ply][0]))
         {
-            tampon_ab = ab_max (copy, (depth <= 2) ? 0 : depth - 2,
-                                result_ab, player_init);
-
-            /* Test if this beta is better and copy the beta of the min son
-             * in this min. */
-            if (tampon_ab.alpha > result_ab.alpha)
-            {
-                result_ab.alpha = tampon_ab.alpha;
-            }
+            score = order_killer[0];
+        }
+        else if (same_move (move, search->killers[ply][1]))
+        {
+            score = order_killer[1];
         }
         else
         {
-            tampon_ab = ab_min (copy, depth - 1, result_ab, player_init);
+            score = square_priority (size, move) +
+                    player_history[move.row * MAX_BOARD_SIZE + move.column];
 
-            /* Alpha in the max become beta in the min. */
-            if (tampon_ab.beta > result_ab.alpha)
+            /* Fastest-first: the less moves left to the opponent, the
+             * better (too slow for the nodes near the leaves). */
+            if (depth >= order_mobility_depth)
             {
-                result_ab.alpha = tampon_ab.beta;
+                undo_t undo;
+                board_do_move (board, move, &undo);
+
+                if (board_player (board) != player)
+                {
+                    score -= order_mobility * board_count_player_moves (board);
+                }
+
+                board_undo_move (board, &undo);
             }
         }
 
-        board_free (copy);
+        moves[count++] = (scored_move_t) {.move = move, .score = score};
+    }
+
+    return count;
+}
+
+/* Put the best move of moves[i], ..., moves[count - 1] in moves[i]
+ *   -> return this move. */
+static move_t
+pick_move (scored_move_t *moves, const size_t i, const size_t count)
+{
+    size_t best = i;
 
-        /* In max node, if a >= b, we can quit this max node. */
-        if (result_ab.alpha >= result_ab.beta)
+    for (size_t j = i + 1; j < count; j++)
+    {
+        if (moves[j].score > moves[best].score)
         {
-            break;
+            best = j;
         }
     }
 
-    return result_ab;
+    scored_move_t swap = moves[i];
+    moves[i] = moves[best];
+    moves[best] = swap;
+
+    return moves[i].move;
 }
 
-/* Calculate the alpha and beta for a min node. */
-static alpha_beta_t
-ab_min (board_t *board, const size_t depth, const alpha_beta_t a_b,
-        const disc_t player_init)
+/* Remember that 'move' of 'player' made a cut in a node searched to
+ * 'depth'. */
+static void
+order_cut (search_t *search, const move_t move, const disc_t player,
+           const size_t depth)
 {
-    if (board == NULL)
+    size_t ply = search->depth_ini + 1 - depth;
+    int *player_history = search->history[(player == BLACK_DISC) ? 0 : 1];
+    size_t square = move.row * MAX_BOARD_SIZE + move.column;
+
+    if (!same_move (move, search->killers[ply][0]))
     {
-        return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
+        search->killers[ply][1] = search->killers[ply][0];
+        search->killers[ply][0] = move;
     }
 
-    /* The player is opponent in ab_min. */
-    disc_t opponent = board_player (board);
-    /* result alpha beta initiate at alpha and beta value to enter. */
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
+    player_history[square] += depth * depth;
 
-    /* Test if depth == 0 or game is over. */
-    if (depth == (size_t) 0)
+    /* Keep the history under the static priorities. */
+    if (player_history[square] > history_max)
     {
-        tampon_ab.beta = score_heuristic (board, player_init);
-
-        if (tampon_ab.beta < result_ab.beta)
+        for (size_t i = 0; i < MAX_BOARD_SIZE * MAX_BOARD_SIZE; i++)
         {
-            result_ab.beta = tampon_ab.beta;
+            player_history[i] /= 2;
         }
+    }
+}
+
+/* ----------------------------- Endgame solver ----------------------------- */
 
-        return result_ab;
+/* If 'board' has at most endgame_empties empty squares, search its best move
+ * by perfect play with the endgame solver
+ *   -> return true and store it in 'move' if so. */
+static bool
+endgame_move (search_t *search, board_t *board, move_t *move)
+{
+    if (count_empties (board) > endgame_empties)
+    {
+        return false;
     }
 
-    /* For all possible moves we take the minimum of score_heuristic. */
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    search_init (search);
+    struct timespec start;
+    stats_start (search, &start);
+    int score;
+    move_t best_move = endgame_best_move (board, tt, &score,
+                                          &search->stats.nodes);
+
+    if (best_move.row >= MAX_BOARD_SIZE)
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+        return false;
+    }
 
-        if (copy == NULL)
-        {
-            board_free (copy);
-            return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        }
+    if (search->verbose)
+    {
+        printf ("\033[A\33[2K"); /* Don't write the last printf. */
+        printf ("The AI solved the end of the game: final score %+d.\n",
+                score);
+    }
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+    stats_report (search, "endgame", count_empties (board), start);
 
-        /* If game is over. */
-        if (board_player (copy) == EMPTY_DISC)
+    *move = best_move;
+
+    return true;
+}
+
+/* ------------------------------ Opening book ------------------------------ */
+
+/* If 'board' is in the opening book, store its best move in 'move'
+ *   -> return true if so. */
+static bool
+book_move (search_t *search, const board_t *board, move_t *move)
+{
+    int score;
+
+    if (!book_lookup (book, board, move, &score))
+    {
+        return false;
+    }
+
+    if (search->verbose)
+    {
+        printf ("\033[A\33[2K"); /* Don't write the last printf. */
+        printf ("The AI played a move of the opening book: score %+d.\n",
+                score);
+    }
+
+    return true;
+}
+
+/* ------------------------------ Alpha / Beta ------------------------------ */
+
+/* Value for 'player' of the board just played by 'player' (with the move of a
+ * node searched to 'depth'), searched with the window ['alpha', 'beta']. */
+static int
+child_value (search_t *search, board_t *board, const size_t depth,
+             const int alpha, const int beta, const disc_t player,
+             const disc_t player_init, const search_policy_t *policy)
+{
+    disc_t next_player = board_player (board);
+
+    /* If game is over. */
+    if (next_player == EMPTY_DISC)
+    {
+        return evaluate (search, board, player);
+    }
+
+    /* If the opponent pass, the player play again (and it cost a depth). */
+    if (next_player == player)
+    {
+        return negamax (search, board, (depth <= 2) ? 0 : depth - 2, alpha,
+                        beta, player_init, policy);
+    }
+
+    /* Else opponent's turn: his value is the opposite of ours. */
+    return -negamax (search, board, depth - 1, -beta, -alpha, player_init,
+                     policy);
+}
+
+/* Negamax search of 'board' to 'depth' with the window ['alpha', 'beta'], as
+ * a principal variation search: the first move is searched with the whole
+ * window, the next ones with a null window only to prove that they are not
+ * better (and searched again if they are)
+ *   -> return the value of the board for the player to move. */
+static int
+negamax (search_t *search, board_t *board, const size_t depth, int alpha,
+         const int beta, const disc_t player_init,
+         const search_policy_t *policy)
+{
+    if (board == NULL)
+    {
+        return -infinity;
+    }
+
+    /* The result of an interrupted search is not used. */
+    if (search_timeout (search) || split_aborted (search))
+    {
+        return alpha;
+    }
+
+    search->stats.nodes++;
+
+    disc_t player = board_player (board);
+
+    /* Test if depth == 0. */
+    if (depth == (size_t) 0)
+    {
+        return evaluate (search, board, player);
+    }
+
+    int value;
+    bool near_root = policy != NULL &&
+                     depth + policy->near_root >= search->depth_ini;
+
+    /* Near the root, the tactic may decide the value by itself. */
+    if (near_root &&
+        policy->node_value (search, board, depth, player_init, &value))
+    {
+        return value;
+    }
+
+    move_t tt_move;
+
+    /* A previous search of this position may be enough (and else its best
+     * move is searched first). */
+    if (tt_cutoff (search, board, depth, alpha, beta, &value, &tt_move) &&
+        !near_root)
+    {
+        return value;
+    }
+
+    const int alpha_ini = alpha;
+    int best_value = -infinity;
+    move_t best_move = {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
+    scored_move_t moves[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    size_t count = order_moves (search, board, board_moves (board), depth,
+                                tt_move, moves);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        /* Once the first move gave a bound, the other threads help. */
+        if (i == 1 && search->pool != NULL && depth >= split_depth)
         {
-            /* Alpha take the maximum value between score and alpha. */
-            tampon_ab.alpha = score_heuristic (copy, player_init);
+            best_value = split_search (search, board, moves, count, depth,
+                                       alpha, beta, best_value, player_init,
+                                       policy, false, &best_move);
 
-            if (tampon_ab.alpha < result_ab.alpha)
+            if (best_value >= beta)
             {
-                result_ab.beta = tampon_ab.alpha;
+                order_cut (search, best_move, player, depth);
             }
+
+            break;
+        }
+
+        move_t move = pick_move (moves, i, count);
+        undo_t undo;
+
+        /* Play the next i-th possible moves on the board. */
+        board_do_move (board, move, &undo);
+
+        if (best_value == -infinity)
+        {
+            value = child_value (search, board, depth, alpha, beta, player,
+                                 player_init, policy);
         }
-        else if (board_player (copy) == opponent)
+        else
         {
-            /* Min node. */
-            tampon_ab = ab_min (copy, (depth <= 2) ? 0 : depth - 2,
-                                result_ab, player_init);
+            value = child_value (search, board, depth, alpha, alpha + 1, player,
+                                 player_init, policy);
 
-            if (tampon_ab.beta < result_ab.beta)
+            /* Better than the best move: get its exact value. */
+            if (value > alpha && value < beta)
             {
-                result_ab.beta = tampon_ab.beta;
+                value = child_value (search, board, depth, alpha, beta, player,
+                                     player_init, policy);
             }
         }
-        else
+
+        board_undo_move (board, &undo);
+
+        if (value > best_value)
         {
-            /* Max node. */
-            tampon_ab = ab_max (copy, depth - 1, result_ab, player_init);
+            best_value = value;
+            best_move = move;
 
-            /* Alpha in the max become beta in the min. */
-            if (tampon_ab.alpha < result_ab.beta)
+            if (value > alpha)
             {
-                result_ab.beta = tampon_ab.alpha;
+                alpha = value;
             }
         }
 
-        board_free (copy);
-
-        /* If alpha >= beta stop, else pass at the next iteration. */
-        if (result_ab.alpha >= result_ab.beta)
+        /* If a >= b, the opponent will never let us reach this node. */
+        if (alpha >= beta)
         {
+            stats_cutoff (search, i);
+            order_cut (search, move, player, depth);
+
             break;
         }
     }
 
-    return result_ab;
+    if (!near_root && !split_aborted (search))
+    {
+        tt_save (board, depth, alpha_ini, beta, best_value, best_move);
+    }
+
+    return best_value;
+}
+
+/* Root of the alpha / beta search (to depth_ini). */
+static move_t
+ab_root (search_t *search, board_t *board, move_t best_move)
+{
+    /* Alpha / beta has no policy. */
+    return ab_main_loop (search, board, board_moves (board), best_move, NULL);
 }
 
 move_t
 minimax_ab_player (board_t *board)
 {
+    search_t *search = &main_search;
+
+    /* No statistics until a search is done. */
+    memset (&last_stats, 0, sizeof (search_stats_t));
+
     if (board == NULL)
     {
         return (move_t) {.row = MAX_BOARD_SIZE + 1,
@@ -949,35 +1642,35 @@ minimax_ab_player (board_t *board)
     switch (board_size (board))
     {
         case 4 :
-            depth_ini = 12;
+            search->depth_ini = 12;
 
             break;
 
         case 6 :
-            depth_ini = 10;
+            search->depth_ini = 10;
 
             break;
 
         case 8 :
-            depth_ini = 7;
+            search->depth_ini = 7;
 
             break;
 
         default :
-            depth_ini = 5;
+            search->depth_ini = 5;
     }
 
     disc_t player_init = board_player (board);
 
-    if (verbose)
+    if (search->verbose)
     {
         printf ("Wait the AI '%c' compute:\n", player_init);
     }
 
     /* Keep the verbose test. */
-    bool is_it_verbose_true = verbose;
+    bool is_it_verbose_true = search->verbose;
     /* Make verbose false to don't do printf in the random_player (). */
-    verbose = false;
+    search->verbose = false;
     /* By default, best move is random -> for the badest possibility that AI
     * don't have a best_move, it need to choose one finally. */
     move_t best_move = random_player (board);
@@ -985,27 +1678,32 @@ minimax_ab_player (board_t *board)
     /* Make verbose true again if it was true before. */
     if (is_it_verbose_true)
     {
-        verbose = true;
+        search->verbose = true;
     }
 
     size_t number_max_moves = board_count_player_moves (board);
 
     if (number_max_moves == 1)
     {
-        best_move = board_next_move (board);
+        move_iter_t iter = move_iter_init (board);
+        move_iter_next (&iter, &best_move);
 
-        if (verbose)
+        if (search->verbose)
         {
             printf ("\033[A\33[2K"); /* Don't write the last printf. */
         }
     }
-    else
+    /* The opening book, then near the end of the game, the solver plays
+     * perfectly. */
+    else if (!book_move (search, board, &best_move) &&
+             !endgame_move (search, board, &best_move))
     {
-        /* Ai pointer function = 0. */
-        best_move = ab_main_loop (0, board, best_move);
+        search_init (search);
+        /* Root search pointer function = 1. */
+        best_move = iterative_deepening (search, 1, board, best_move);
     }
 
-    if (verbose)
+    if (search->verbose)
     {
         print_move_verbose (best_move, player_init, 3);
     }
@@ -1015,760 +1713,886 @@ minimax_ab_player (board_t *board)
 
 /* ----------------------------- Newton tactics ----------------------------- */
 
-/* Calculate the alpha and beta for a max node in newton_player. */
-static alpha_beta_t
-newton_max (board_t *board, const size_t depth, const alpha_beta_t a_b,
-            const disc_t player_init)
+/* Newton valorize the branches where it can play a corner two plies under the
+ * root and reject the ones where the opponent can play a corner one ply under
+ * the root. */
+static bool
+newton_node_value (const search_t *search, const board_t *board,
+                   const size_t depth, const disc_t player_init, int *value)
 {
-    if (board == NULL)
+    size_t size = board_size (board);
+    bitboard_t corner0 = (bitboard_t) 1;
+    bitboard_t corner1 = corner0 << (size - 1);
+    bitboard_t corner3 = corner0 << (size * size - 1);
+    bitboard_t corner2 = corner3 >> (size - 1);
+
+    if ((board_moves (board) & (corner0 | corner1 | corner2 | corner3)) ==
+        (bitboard_t) 0)
     {
-        return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        /* Only in C11 version */
+        return false;
     }
 
-    /* The player is opponent in min. */
-    disc_t player = board_player (board);
-    /* Tampon alpha beta initiate at alpha and beta value to enter. */
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
+    /* If at this max node, AI can play corner, then valorize this branch. */
+    if (board_player (board) == player_init && depth + 2 == search->depth_ini)
+    {
+        *value = size * size;
 
-    /* Test if depth == 0 or game is over. */
-    if (depth == (size_t) 0)
+        return true;
+    }
+
+    /* If opposent's move is a corner, then the branch will not be taken. */
+    if (board_player (board) != player_init && depth + 1 == search->depth_ini)
     {
-        tampon_ab.alpha = score_heuristic (board, player_init);
+        *value = infinity;
 
-        if (tampon_ab.alpha > result_ab.alpha)
-        {
-            result_ab.alpha = tampon_ab.alpha;
-        }
+        return true;
+    }
+
+    return false;
+}
 
-        return result_ab;
+/* Policy of newton_player. */
+static const search_policy_t newton_policy = {newton_node_value, 2};
+
+/* Root of the Newton search (to depth_ini): the loop alpha/beta on the
+ * interesting corners, else on the interesting borders, else on all the
+ * moves. */
+static move_t
+newton_root (search_t *search, board_t *board, move_t best_move)
+{
+    bitboard_t corner = get_corners_to_exam (board);
+
+    if (corner != (bitboard_t) 0)
+    {
+        return ab_main_loop (search, board, corner, best_move, &newton_policy);
     }
 
-    /* For all possible moves we take the minimum of score_heuristic. */
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    bitboard_t interesting_borders = get_interesting_borders (board);
+
+    if (interesting_borders != (bitboard_t) 0)
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        size_t size = board_size (board);
-        const int int_max = size * size;
+        return ab_main_loop (search, board, interesting_borders, best_move,
+                             &newton_policy);
+    }
 
-        /* If at this max node, AI can play corner,
-         * then valorize this branch. */
-        if (is_corner (size, move) && depth == depth_ini - 2)
-        {
-            return (alpha_beta_t) {.alpha = int_max, .beta = a_b.beta};
-        }
+    return ab_main_loop (search, board, board_moves (board), best_move,
+                         &newton_policy);
+}
 
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+move_t
+newton_player (board_t *board)
+{
+    search_t *search = &main_search;
 
-        if (copy == NULL)
-        {
-            return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        }
+    /* No statistics until a search is done. */
+    memset (&last_stats, 0, sizeof (search_stats_t));
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+    if (board == NULL)
+    {
+        return (move_t) {.row = MAX_BOARD_SIZE + 1,
+                         .column = MAX_BOARD_SIZE + 1};
+    }
 
-        /* If game is over. */
-        if (board_player (copy) == EMPTY_DISC)
-        {
-            /* Alpha take the maximum value between score and alpha. */
-            tampon_ab.beta = score_heuristic (copy, player_init);
+    switch (board_size (board))
+    {
+        case 4 :
+            search->depth_ini = 12;
 
-            if (tampon_ab.beta > result_ab.alpha)
-            {
-                result_ab.alpha = tampon_ab.beta;
-            }
-        }
-        else if (board_player (copy) == player)
-        {
-            /* Max node. */
-            tampon_ab = newton_max (copy, (depth <= 2) ? 0 : depth - 2,
-                                    result_ab, player_init);
+            break;
 
-            if (tampon_ab.alpha > result_ab.alpha)
-            {
-                result_ab.alpha = tampon_ab.alpha;
-            }
-        }
-        else
-        {
-            /* Min node. */
-            tampon_ab = newton_min (copy, depth - 1, result_ab,
-                                    player_init);
+        case 6 :
+            search->depth_ini = 10;
 
-            if (tampon_ab.beta > result_ab.alpha)
-            {
-                /* Beta in min become alpha in max. */
-                result_ab.alpha = tampon_ab.beta;
-            }
-        }
+            break;
 
-        board_free (copy);
+        case 8 :
+            search->depth_ini = 7;
 
-        /* In max node, if a >= b, we can quit this max node. */
-        if (result_ab.alpha >= result_ab.beta)
-        {
             break;
-        }
+
+        default :
+            search->depth_ini = 5;
     }
 
-    return result_ab;
-}
+    disc_t player_init = board_player (board);
 
-/* Calculate the alpha and beta for a min node in newton_player. */
-static alpha_beta_t
-newton_min (board_t *board, const size_t depth, const alpha_beta_t a_b,
-            const disc_t player_init)
-{
-    if (board == NULL)
+    if (search->verbose)
     {
-        return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
+        printf ("Wait the AI '%c' compute:\n", player_init);
     }
 
-    /* The player is opponent in min. */
-    disc_t opponent = board_player (board);
-    /* Result alpha beta initiate at alpha and beta value to enter. */
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = a_b.alpha, .beta = a_b.beta};
+    /* Keep the verbose test. */
+    bool is_verbose = search->verbose;
+    /* Make verbose false to don't do printf in the random_player (). */
+    search->verbose = false;
+    /* By default, best move is random -> for the badest possibility that AI
+     * don't have a best_move, it need to choose one finally. */
+    move_t best_move = random_player (board);
+    /* Make verbose true again if it was true before. */
+    search->verbose = is_verbose;
+    size_t number_max_moves = board_count_player_moves (board);
 
-    /* Test if depth == 0 or game is over. */
-    if (depth == (size_t) 0)
+    if (number_max_moves == 1)
     {
-        tampon_ab.beta = score_heuristic (board, player_init);
-
-        if (tampon_ab.beta < result_ab.beta)
+        if (search->verbose)
         {
-            result_ab.beta = tampon_ab.beta;
+            printf ("\033[A\33[2K"); /* Don't write the last printf. */
         }
 
-        return result_ab;
+        move_iter_t iter = move_iter_init (board);
+        move_iter_next (&iter, &best_move);
+
+        return best_move;
     }
 
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    /* The opening book, then near the end of the game, the solver plays
+     * perfectly. */
+    if (book_move (search, board, &best_move) ||
+        endgame_move (search, board, &best_move))
     {
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-
-        /* If opposent's move is a corner,
-         * then stop this branch. */
-        if (is_corner (board_size (board), move) && depth == depth_ini - 1)
+        if (search->verbose)
         {
-            /* Return just alpha > beta at infinity to be sure that this branch
-             * will not be taken. */
-            return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
+            print_move_verbose (best_move, player_init, 4);
         }
 
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+        return best_move;
+    }
 
-        if (copy == NULL)
-        {
-            return (alpha_beta_t) {.alpha = infinity, .beta = -infinity};
-        }
+    size_t size = board_size (board);
+    search_init (search);
 
-        /* Play the next i-th possible moves on this copy. */
-        board_play (copy, move);
+    /* Management of the corners. */
+    bitboard_t corner = get_corners_to_exam (board);
+    size_t count = bitboard_popcount (corner);
+    bitboard_t corner0 = (bitboard_t) 1;
+    bitboard_t corner1 = corner0 << (size - 1);
+    bitboard_t corner3 = corner0 << (size * size - 1);
+    bitboard_t corner2 = corner3 >> (size - 1);
+    bitboard_t corners[4] = {corner0, corner1, corner2, corner3};
 
-        /* If game is over. */
-        if (board_player (copy) == EMPTY_DISC)
+    /* If just one corner -> through it and do it. */
+    if (count == 1)
+    {
+        for (short i = 0; i < 4; i++)
         {
-            /* Alpha take the maximum value between score and alpha. */
-            tampon_ab.alpha = score_heuristic (copy, player_init);
-
-            if (tampon_ab.alpha < result_ab.alpha)
+            if ((corner & corners[i]) == corners[i])
             {
-                result_ab.beta = tampon_ab.alpha;
+                best_move = get_corner_as_move (size, i);
+
+                if (search->verbose)
+                {
+                    printf ("\033[A\33[2K");
+                    print_move_verbose (best_move, player_init, 4);
+                }
+
+                return best_move;
             }
         }
-        else if (board_player (copy) == opponent)
+    }
+    /* Management of the borders if there is no corner. */
+    else if (count == 0)
+    {
+        bitboard_t interesting_borders = get_interesting_borders (board);
+
+        /* If just one border -> through it and do it. */
+        if (bitboard_popcount (interesting_borders) == 1)
         {
-            /* Min node. */
-            tampon_ab = newton_min (copy, (depth <= 2) ? 0 : depth - 2,
-                                    result_ab, player_init);
+            bitboard_t *borders = get_borders (size);
 
-            if (tampon_ab.beta < result_ab.beta)
+            for (short i = 0; i < 4; i++)
             {
-                result_ab.beta = tampon_ab.beta;
+                if ((borders[i] & interesting_borders) == interesting_borders)
+                {
+                    best_move = get_border_as_move (interesting_borders, size,
+                                                    i);
+
+                    if (search->verbose)
+                    {
+                        printf ("\033[A\33[2K");
+                        print_move_verbose (best_move, player_init, 4);
+                    }
+                    free (borders);
+
+                    return best_move;
+                }
             }
         }
-        else
-        {
-            /* Max node. */
-            tampon_ab = newton_max (copy, depth - 1, result_ab,
-                                    player_init);
+    }
 
-            if (tampon_ab.alpha < result_ab.beta)
-            {
-                /* Alpha in the max become beta in the min. */
-                result_ab.beta = tampon_ab.alpha;
-            }
+    /* Else make the loop alpha/beta on the corners, the borders or all the
+     * moves to through the best (root search pointer function = 2). */
+    best_move = iterative_deepening (search, 2, board, best_move);
+
+    if (search->verbose)
+    {
+        print_move_verbose (best_move, player_init, 4);
+    }
+
+    return best_move;
+}
+
+int
+newton_value (board_t *board, const size_t depth, move_t *move)
+{
+    search_t search = {.threads = 1, .depth_ini = depth};
+    int score;
+
+    /* The first thread allocates the table for all of them. */
+    pthread_mutex_lock (&tt_lock);
+
+    if (tt == NULL && hash_megabytes > 0)
+    {
+        tt = tt_alloc (hash_megabytes);
+    }
+
+    pthread_mutex_unlock (&tt_lock);
+
+    if (count_empties (board) <= endgame_empties)
+    {
+        *move = endgame_best_move (board, tt, &score, NULL);
+
+        if (move->row < MAX_BOARD_SIZE)
+        {
+            return score;
         }
+    }
 
-        board_free (copy);
+    search_reset (&search);
+
+    move_iter_t iter = move_iter_init (board);
+    move_iter_next (&iter, move);
+    *move = newton_root (&search, board, *move);
+
+    return search.value;
+}
 
-        /* If alpha >= beta stop, else pass at the next iteration. */
-        if (result_ab.alpha >= result_ab.beta)
+/* ---------------------------- Parallel search ----------------------------- */
+
+/* Tell if the split point 'split' is 'ancestor' or one of its descendants. */
+static bool
+split_descends (const split_t *split, const split_t *ancestor)
+{
+    for (; split != NULL; split = split->parent)
+    {
+        if (split == ancestor)
         {
-            break;
+            return true;
         }
     }
 
-    return result_ab;
+    return false;
 }
 
-/* Make the loop on all possible and interesting corners that AI can do. */
-static move_t
-newton_corner_loop (const short ai, board_t *board, move_t best_move,
-                    bitboard_t corners[4], bitboard_t corner)
+/* Search the moves of 'split' not taken yet by the other threads, with
+ * 'search' on 'board' (the node of the split point), until there is no more
+ * or a move made a cut. */
+static void
+split_loop (split_t *split, search_t *search, board_t *board)
 {
-    size_t count = 0;
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    disc_t player_init = board_player (board);
-    size_t number_max_moves = board_count_player_moves (board);
+    split_t *outer = search->split;
+    search->split = split;
+    disc_t player = board_player (board);
 
-    /* We need to take the corner that need to be save first! */
-    for (short i = 0; i < 4; i++)
+    while (true)
     {
-        if ((corner & corners[i]) == (bitboard_t) 0)
+        pthread_mutex_lock (&split->lock);
+        size_t i = split->next++;
+        int alpha = split->alpha;
+        size_t best = split->best;
+        pthread_mutex_unlock (&split->lock);
+
+        if (i >= split->count || split->cut)
         {
-            continue;
+            break;
         }
 
-        move_t move = get_corner_as_move (board_size (board), i);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+        /* As in the search of a single thread, a move of the root before the
+         * best one in the order is better if it is as good. */
+        int bound = (split->root && i < best) ? alpha - 1 : alpha;
+        undo_t undo;
 
-        if (copy == NULL)
-        {
-            board_free (copy);
+        board_do_move (board, split->moves[i].move, &undo);
 
-            return (move_t) {.row = MAX_BOARD_SIZE + 1,
-                             .column = MAX_BOARD_SIZE + 1};
+        int value = child_value (search, board, split->depth, bound, bound + 1,
+                                 player, split->player_init, split->policy);
+
+        if (value > bound && value < split->beta)
+        {
+            value = child_value (search, board, split->depth, bound,
+                                 split->beta, player, split->player_init,
+                                 split->policy);
         }
 
-        /* Play the next i-th possible moves. */
-        board_play (copy, move);
+        board_undo_move (board, &undo);
 
-        if (board_player (copy) == EMPTY_DISC)
+        /* The value of an interrupted search is not used. */
+        if (time_out || split_aborted (search))
         {
-            int score = score_heuristic (copy, player_init);
+            break;
+        }
 
-            if (verbose && score != 0)
-            {
-                count++;
-                print_progress (count, number_max_moves, player_init);
-            }
+        pthread_mutex_lock (&split->lock);
 
-            /* If player init win, just do it. */
-            if (score > 0)
-            {
-                board_free (copy);
-                best_move = move;
+        if (value > split->best_value ||
+            (split->root && value == split->best_value && i < split->best))
+        {
+            split->best_value = value;
+            split->best = i;
 
-                break;
-            }
-            /* If player init lost, don't select this move. */
-            else if (score < 0)
+            if (value > split->alpha)
             {
-                board_free (copy);
-
-                continue;
+                split->alpha = value;
             }
-            /* Else score = 0, let evaluate it. */
-            else
+
+            /* The other threads stop to search this node. */
+            if (split->alpha >= split->beta)
             {
-                tampon_ab.beta = score;
+                split->cut = true;
+                stats_cutoff (search, i);
             }
         }
-        /* Test if it's opponent -> minimisation. */
-        else if (board_player (copy) != player_init)
-        {
-            tampon_ab  = ab_min_used[ai] (copy, depth_ini, result_ab,
-                                          player_init);
-        }
-        /* Test if it's same player -> maximisation. */
-        else
+
+        split->done++;
+
+        if (split->root && search->verbose)
         {
-            tampon_ab  = ab_max_used[ai] (copy, depth_ini, result_ab,
-                                          player_init);
+            print_progress (split->done, split->count, split->player_init);
         }
 
-        /* If alpha >= beta, pass at the next move. */
-        if (tampon_ab.alpha >= tampon_ab.beta)
+        pthread_mutex_unlock (&split->lock);
+    }
+
+    search->split = outer;
+}
+
+/* Look in the deques of the other threads of the pool for the oldest split
+ * point (descending from 'ancestor' if it is not NULL) with moves left, and
+ * join it
+ *   -> return this split point or NULL if there is none. */
+static split_t *
+split_steal (const search_t *search, const split_t *ancestor)
+{
+    pool_t *pool = search->pool;
+
+    for (size_t k = 1; k < pool->count; k++)
+    {
+        deque_t *deque = &pool->deques[(search->id + k) % pool->count];
+        split_t *found = NULL;
+
+        pthread_mutex_lock (&deque->lock);
+
+        for (size_t i = 0; i < deque->count && found == NULL; i++)
         {
-            if (verbose)
+            split_t *split = deque->splits[i];
+
+            if (ancestor != NULL && !split_descends (split, ancestor))
             {
-                count++;
-                print_progress (count, number_max_moves, player_init);
+                continue;
             }
 
-            board_free (copy);
+            /* Joined under the lock of the deque: the owner can't finish the
+             * split point before the thread leave it. */
+            pthread_mutex_lock (&split->lock);
 
-            continue;
-        }
+            if (split->next < split->count && !split->cut)
+            {
+                split->workers++;
+                found = split;
+            }
 
-        /* If beta son > actual alpha, it's a better move.*/
-        if (tampon_ab.beta > result_ab.alpha)
-        {
-            /* In max node, beta son become alpha. */
-            result_ab.alpha = tampon_ab.beta;
-            best_move = move;
+            pthread_mutex_unlock (&split->lock);
         }
 
-        board_free (copy);
+        pthread_mutex_unlock (&deque->lock);
 
-        /* To print the progress barre on the consol. */
-        if (verbose)
+        if (found != NULL)
         {
-            count++;
-            print_progress (count, number_max_moves, player_init);
+            return found;
         }
     }
 
-    /* To print the final barre on the consol. */
-    if (verbose)
+    return NULL;
+}
+
+/* Help the owner of 'split' (joined by split_steal ()) with 'search'. */
+static void
+split_work (split_t *split, search_t *search)
+{
+    board_t *board = board_copy (split->board);
+
+    if (board != NULL)
     {
-        print_progress (number_max_moves, number_max_moves, player_init);
+        split_loop (split, search, board);
+        board_free (board);
     }
 
-    return best_move;
+    pthread_mutex_lock (&split->lock);
+    split->workers--;
+    pthread_mutex_unlock (&split->lock);
 }
 
-/* Make the loop on all possible and interesting borders that AI can do. */
-static move_t
-newton_border_loop (const short ai, bitboard_t playable_borders,
-                        board_t *board)
+/* Body of a helper thread: steal the split points of the others until the
+ * search is over. */
+static void *
+pool_helper (void *helper)
 {
-    size_t size = board_size (board);
-    size_t* increment = get_borders_increment (size);
-    bitboard_t* borders = get_borders (size);
-    bitboard_t* borders_init = get_boarders_init (size);
+    search_t *search = &((helper_t *) helper)->search;
 
-    if (board == NULL || increment == NULL ||
-        borders == NULL || borders_init == NULL)
+    while (!search->pool->finished)
     {
-        if (increment != NULL)
-        {
-            free (increment);
-        }
+        split_t *split = split_steal (search, NULL);
 
-        if (borders != NULL)
+        if (split != NULL)
         {
-            free (borders);
+            split_work (split, search);
         }
-
-        if (borders_init != NULL)
+        else
         {
-            free (borders_init);
+            sched_yield ();
         }
-
-        return (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
     }
 
-    size_t count = 0;
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    disc_t player_init = board_player (board);
-    size_t number_max_moves = board_count_player_moves (board);
-    move_t best_move;
-    bool out = false;
+    return NULL;
+}
 
-    for (short i = 0; i < 4; i++)
+/* Start the helper threads of a parallel search of 'search' in 'pool' and
+ * 'helpers' (the threads that can't start are ignored: their deques stay
+ * empty). */
+static void
+pool_start (search_t *search, pool_t *pool, helper_t *helpers)
+{
+    pool->count = search->threads;
+    pool->started = 0;
+    pool->finished = false;
+    search->pool = pool;
+    search->id = 0;
+    search->split = NULL;
+
+    for (size_t i = 0; i < pool->count; i++)
     {
-        if (out)
-        {
-            break;
-        }
+        pool->deques[i].count = 0;
+        pthread_mutex_init (&pool->deques[i].lock, NULL);
+    }
+
+    for (size_t i = 0; i + 1 < pool->count; i++)
+    {
+        helpers[i].search = *search;
+        helpers[i].search.id = i + 1;
+        memset (&helpers[i].search.stats, 0, sizeof (search_stats_t));
 
-        /* Check how borders is this border. */
-        if ((borders[i] & playable_borders) == (bitboard_t) 0)
+        if (pthread_create (&helpers[i].thread, NULL, pool_helper,
+                            &helpers[i]) != 0)
         {
-            continue;
+            break;
         }
 
-        /* Check the position on the i-th border (without corner). */
-        for (size_t j = 1; j < size - 1; j++)
-        {
-            bitboard_t bit = borders_init[i] << (j * increment[i]);
+        pool->started++;
+    }
+}
 
-            if ((bit & playable_borders) != bit)
-            {
-                continue;
-            }
+/* Stop the helper threads of the parallel search of 'search'. */
+static void
+pool_stop (search_t *search, helper_t *helpers)
+{
+    pool_t *pool = search->pool;
+    pool->finished = true;
 
-            move_t move = get_border_as_move (bit, size, i);
-            board_t *copy = board_copy (board);
+    for (size_t i = 0; i < pool->started; i++)
+    {
+        pthread_join (helpers[i].thread, NULL);
+        stats_add (&search->stats, &helpers[i].search.stats);
+    }
 
-            if (copy == NULL)
-            {
-                return (move_t) {.row = MAX_BOARD_SIZE + 1,
-                                 .column = MAX_BOARD_SIZE + 1};
-            }
+    for (size_t i = 0; i < pool->count; i++)
+    {
+        pthread_mutex_destroy (&pool->deques[i].lock);
+    }
 
-            /* Play the next i-th possible moves. */
-            board_play (copy, move);
+    search->pool = NULL;
+}
 
-            if (board_player (copy) == EMPTY_DISC)
-            {
-                int score = score_heuristic (copy, player_init);
+/* Search the moves of 'board' from the second one of 'moves' with all the
+ * threads of the pool, knowing that the first one has the value 'best_value'
+ * (searched to 'depth' with the window ['alpha', 'beta'] as the other ones).
+ * If it is better, store the best move in 'best_move'
+ *   -> return the best value. */
+static int
+split_search (search_t *search, board_t *board, const scored_move_t *moves,
+              const size_t count, const size_t depth, const int alpha,
+              const int beta, const int best_value, const disc_t player_init,
+              const search_policy_t *policy, const bool root,
+              move_t *best_move)
+{
+    split_t split = {.parent = search->split,
+                     .board = board_copy (board),
+                     .count = count,
+                     .depth = depth,
+                     .beta = beta,
+                     .player_init = player_init,
+                     .policy = policy,
+                     .root = root,
+                     .next = 1,
+                     .done = 1,
+                     .workers = 0,
+                     .alpha = (best_value > alpha) ? best_value : alpha,
+                     .best_value = best_value,
+                     .best = (best_value > -infinity) ? 0 : count,
+                     .cut = false};
 
-                if (verbose && score != 0)
-                {
-                    count++;
-                    print_progress (count, number_max_moves, player_init);
-                }
+    memcpy (split.moves, moves, count * sizeof (scored_move_t));
 
-                /* If player init win, just do it. */
-                if (score > 0)
-                {
-                    board_free (copy);
-                    best_move = move;
-                    out = true;
+    /* The threads take the moves in the order of a single thread. */
+    for (size_t i = 1; i < count; i++)
+    {
+        pick_move (split.moves, i, count);
+    }
 
-                    break;
-                }
-                /* If player init lost, don't select this move. */
-                else if (score < 0)
-                {
-                    board_free (copy);
+    pthread_mutex_init (&split.lock, NULL);
+    deque_t *deque = &search->pool->deques[search->id];
 
-                    continue;
-                }
-                /* Else score = 0, let evaluate it. */
-                else
-                {
-                    tampon_ab.beta = score;
-                }
-            }
-            /* Test if it's opponent -> minimisation. */
-            else if (board_player (copy) != player_init)
-            {
-                tampon_ab  = ab_min_used[ai] (copy, depth_ini, result_ab,
-                                              player_init);
-            }
-            /* Test if it's same player -> maximisation. */
-            else
-            {
-                tampon_ab  = ab_max_used[ai] (copy, depth_ini, result_ab,
-                                              player_init);
-            }
+    /* Without a copy of the node, the other threads can't help. */
+    if (split.board != NULL)
+    {
+        pthread_mutex_lock (&deque->lock);
+        deque->splits[deque->count++] = &split;
+        pthread_mutex_unlock (&deque->lock);
+    }
 
-            /* If alpha >= beta, pass at the next move. */
-            if (tampon_ab.alpha >= tampon_ab.beta)
-            {
-                if (verbose)
-                {
-                    count++;
-                    print_progress (count, number_max_moves, player_init);
-                }
+    split_loop (&split, search, board);
 
-                board_free (copy);
+    if (split.board != NULL)
+    {
+        pthread_mutex_lock (&deque->lock);
+        deque->count--;
+        pthread_mutex_unlock (&deque->lock);
+    }
 
-                continue;
-            }
+    /* Wait the threads still working on the split point, and help them on
+     * their own split points meanwhile. */
+    while (true)
+    {
+        pthread_mutex_lock (&split.lock);
+        size_t workers = split.workers;
+        pthread_mutex_unlock (&split.lock);
 
-            /* If beta son > actual alpha, it's a better move. */
-            if (tampon_ab.beta > result_ab.alpha)
-            {
-                /* In max node, beta son become alpha. */
-                result_ab.alpha = tampon_ab.beta;
-                best_move = move;
-            }
+        if (workers == 0)
+        {
+            break;
+        }
 
-            board_free (copy);
+        split_t *task = split_steal (search, &split);
 
-            /* To print the progress barre on the consol. */
-            if (verbose)
-            {
-                count++;
-                print_progress (count, number_max_moves, player_init);
-            }
+        if (task != NULL)
+        {
+            split_work (task, search);
+        }
+        else
+        {
+            sched_yield ();
         }
     }
 
-    if (verbose)
+    board_free (split.board);
+    pthread_mutex_destroy (&split.lock);
+
+    if (split.best < count)
     {
-        print_progress (number_max_moves, number_max_moves, player_init);
+        *best_move = split.moves[split.best].move;
     }
 
-    free (increment);
-    free (borders);
-    free (borders_init);
-
-    return best_move;
+    return split.best_value;
 }
 
-move_t
-newton_player (board_t *board)
+
+/* --------------------- Alpha / Beta & Newton main loop -------------------- */
+
+/* Execute main loop of ab_player and newton_player functions: search the
+ * 'moves' of 'board' (a part of its possible moves) to depth_ini with the
+ * tactic 'policy' (once for the moves that are symmetric by a symmetry of
+ * 'board')
+ *   -> return the best one or 'best_move' if none is better than -infinity. */
+static move_t
+ab_main_loop (search_t *search, board_t *board, const bitboard_t moves,
+              move_t best_move, const search_policy_t *policy)
 {
-    if (board == NULL)
+    if (search->verbose)
     {
-        return (move_t) {.row = MAX_BOARD_SIZE + 1,
-                         .column = MAX_BOARD_SIZE + 1};
+        printf ("\033[A\33[2K"); /* Don't write the last printf. */
     }
 
-    switch (board_size (board))
+    if (board == NULL)
     {
-        case 4 :
-            depth_ini = 12;
-
-            break;
-
-        case 6 :
-            depth_ini = 10;
-
-            break;
-
-        case 8 :
-            depth_ini = 7;
-
-            break;
-
-        default :
-            depth_ini = 5;
+        return (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
     }
 
+    /* Initialize a at -infinity (b stay at +infinity). */
+    int alpha = -infinity;
+    bool first = true;
     disc_t player_init = board_player (board);
+    /* The root is at depth_ini + 1. */
+    size_t depth = search->depth_ini + 1;
+    scored_move_t ordered[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    /* The moves symmetric to another one are not searched. */
+    size_t number_max_moves = order_moves (search, board,
+                                           board_unique_moves (board, moves),
+                                           depth, best_move, ordered);
+
+    /* The other threads help to search the nodes (at the root and deeper). */
+    pool_t pool = {.deques = NULL};
+    helper_t *helpers = NULL;
 
-    if (verbose)
+    if (search->threads > 1)
     {
-        printf ("Wait the AI '%c' compute:\n", player_init);
-    }
+        pool.deques = malloc (search->threads * sizeof (deque_t));
+        helpers = malloc ((search->threads - 1) * sizeof (helper_t));
 
-    /* Keep the verbose test. */
-    bool is_verbose = verbose;
-    /* Make verbose false to don't do printf in the random_player (). */
-    verbose = false;
-    /* By default, best move is random -> for the badest possibility that AI
-     * don't have a best_move, it need to choose one finally. */
-    move_t best_move = random_player (board);
-    /* Make verbose true again if it was true before. */
-    verbose = is_verbose;
-    size_t number_max_moves = board_count_player_moves (board);
+        if (pool.deques != NULL && helpers != NULL)
+        {
+            pool_start (search, &pool, helpers);
+        }
+    }
 
-    if (number_max_moves == 1)
+    for (size_t i = 0; i < number_max_moves; i++)
     {
-        if (verbose)
+        /* Once the first move gave a bound, the other threads help. */
+        if (i == 1 && search->pool != NULL)
         {
-            printf ("\033[A\33[2K"); /* Don't write the last printf. */
+            alpha = split_search (search, board, ordered, number_max_moves,
+                                  depth, alpha, infinity, alpha, player_init,
+                                  policy, true, &best_move);
+
+            break;
         }
 
-        return board_next_move (board);
-    }
+        move_t move = pick_move (ordered, i, number_max_moves);
 
-    size_t size = board_size (board);
+        if (search->verbose)
+        {
+            print_progress (i, number_max_moves, player_init);
+        }
 
-    /* Management of the corners. */
-    bitboard_t corner = get_corners_to_exam (board);
-    size_t count = bitboard_popcount (corner);
-    bitboard_t corner0 = (bitboard_t) 1;
-    bitboard_t corner1 = corner0 << (size - 1);
-    bitboard_t corner3 = corner0 << (size * size - 1);
-    bitboard_t corner2 = corner3 >> (size - 1);
-    bitboard_t corners[4] = {corner0, corner1, corner2, corner3};
-    short ai = 1; /* Pointer function is 1 for newton_player. */
+        undo_t undo;
+        int value;
 
-    /* If just one corner -> through it and do it. */
-    if (count == 1)
-    {
-        for (short i = 0; i < 4; i++)
+        /* Play the next i-th possible moves. */
+        board_do_move (board, move, &undo);
+
+        if (first)
         {
-            if ((corner & corners[i]) == corners[i])
+            value = child_value (search, board, depth, alpha, infinity,
+                                 player_init, player_init, policy);
+            first = false;
+        }
+        else
+        {
+            value = child_value (search, board, depth, alpha, alpha + 1,
+                                 player_init, player_init, policy);
+
+            if (value > alpha)
             {
-                best_move = get_corner_as_move (size, i);
+                value = child_value (search, board, depth, alpha, infinity,
+                                     player_init, player_init, policy);
+            }
+        }
 
-                if (verbose)
-                {
-                    printf ("\033[A\33[2K");
-                    print_move_verbose (best_move, player_init, 4);
-                }
+        /* If the game is over and player init win, just do it. */
+        if (board_player (board) == EMPTY_DISC && value > 0)
+        {
+            board_undo_move (board, &undo);
+            alpha = value;
+            best_move = move;
 
-                return best_move;
-            }
+            break;
         }
-    }
-    /* If more than 1 corner -> make the loop alpha/beta to through the best. */
-    else if (count > 1)
-    {
-        best_move = newton_corner_loop (ai, board, best_move, corners, corner);
 
-        if (verbose)
+        board_undo_move (board, &undo);
+
+        /* If it's a better move, it become alpha. */
+        if (value > alpha)
         {
-            print_move_verbose (best_move, player_init, 4);
+            alpha = value;
+            best_move = move;
         }
+    }
 
-        return best_move;
+    if (search->pool != NULL)
+    {
+        pool_stop (search, helpers);
     }
 
-    /* Management of the borders. */
-    bitboard_t interesting_borders = get_interesting_borders (board);
-    count = bitboard_popcount (interesting_borders);
+    free (pool.deques);
+    free (helpers);
+    search->value = alpha;
 
-    /* If just one border -> through it and do it. */
-    if (count == 1)
+    if (search->verbose)
     {
-        bitboard_t *borders = get_borders (size);
+        print_progress (number_max_moves, number_max_moves, player_init);
+    }
 
-        for (short i = 0; i < 4; i++)
-        {
-            if ((borders[i] & interesting_borders) == interesting_borders)
-            {
-                best_move = get_border_as_move (interesting_borders, size, i);
+    return best_move;
+}
 
-                if (verbose)
-                {
-                    printf ("\033[A\33[2K");
-                    print_move_verbose (best_move, player_init, 4);
-                }
-                free (borders);
+/* -------------------------- Iterative deepening --------------------------- */
+
+/* Search 'board' with the root search 'ai' to the depths 'first_depth',
+ * 'first_depth' + 1, ... until the time is over or all the ends of game are
+ * reached, or (if 'start' is the instant when the search started) until the
+ * next depth would take longer than the remaining time. Store in 'best_move'
+ * the best move of the last completed depth
+ *   -> return this depth (0 if none is completed). */
+static size_t
+deepening_loop (search_t *search, const short ai, board_t *board,
+                const size_t first_depth, move_t *best_move,
+                const struct timespec *start)
+{
+    size_t empty = count_empties (board);
+    size_t depth_reached = 0;
 
-                return best_move;
-            }
-        }
-    }
-    /* If more than 1 border -> make the loop alpha/beta to through the best. */
-    else if (count > 1)
+    /* A pass cost one more depth: 2 * empty reach all the ends of game. */
+    for (search->depth_ini = first_depth; search->depth_ini <= 2 * empty;
+         search->depth_ini++)
     {
-        best_move = newton_border_loop (ai, interesting_borders, board);
+        move_t move = root_search_used[ai] (search, board, *best_move);
 
-        if (verbose)
+        if (time_out)
         {
-            print_move_verbose (best_move, player_init, 4);
+            break;
         }
 
-        return best_move;
-    }
-
-    best_move = ab_main_loop (ai, board, best_move); /* ai = 1. */
+        *best_move = move;
+        depth_reached = search->depth_ini;
 
-    /* If no corners and no border, get the normal alpha/beta compute. */
-    if (verbose)
-    {
-        print_move_verbose (best_move, player_init, 4);
+        /* The next depth would take longer than the remaining time. */
+        if (start != NULL && elapsed_since (*start) * 2 > time_per_move)
+        {
+            break;
+        }
     }
 
-    return best_move;
+    return depth_reached;
 }
 
-/* --------------------- Alpha / Beta & Newton main loop -------------------- */
+/* Body of a helper thread of a Lazy SMP search. */
+static void *
+lazy_smp_helper (void *helper)
+{
+    lazy_helper_t *self = helper;
+    self->depth_reached = deepening_loop (&self->search, self->ai,
+                                          self->board, self->first_depth,
+                                          &self->best_move, NULL);
 
-/* Execute main loop of ab_player and newton_player functions. */
+    return NULL;
+}
+
+/* Search the best move of 'board' with the root search 'ai': to depth_ini if
+ * there is no time per move, else to the depths 1, 2, ... until the time is
+ * over. Return the best move of the last completed depth ('best_move' if not
+ * even the first one is completed).
+ * With a time per move, the other threads run a Lazy SMP search: each one
+ * deepens its own search of the root (half of them one depth ahead), and they
+ * only share the transposition table. The move of the deepest completed
+ * depth is played. */
 static move_t
-ab_main_loop (const short ai, board_t *board, move_t best_move)
+iterative_deepening (search_t *search, const short ai, board_t *board,
+                     move_t best_move)
 {
-    if (verbose)
-    {
-        printf ("\033[A\33[2K"); /* Don't write the last printf. */
-    }
-
-    if (board == NULL || ai < 0 || ai > 1)
+    if (board == NULL || ai < 0 || ai > 2)
     {
         return (move_t) {.row = MAX_BOARD_SIZE, .column = MAX_BOARD_SIZE};
     }
 
-    /* Initialize a at -infinity and b at +infinity. */
-    alpha_beta_t result_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    alpha_beta_t tampon_ab = (alpha_beta_t)
-                             {.alpha = -infinity, .beta = infinity};
-    disc_t player_init = board_player (board);
-    size_t number_max_moves = board_count_player_moves (board);
+    struct timespec start;
+    stats_start (search, &start);
 
-    for (size_t i = 0; i < board_count_player_moves (board); i++)
+    if (time_per_move <= 0)
     {
-        if (verbose)
-        {
-            print_progress (i, number_max_moves, player_init);
-        }
+        best_move = root_search_used[ai] (search, board, best_move);
+        stats_report (search, root_search_names[ai], search->depth_ini,
+                      start);
 
-        /* Take a possible move. */
-        move_t move = board_next_move (board);
-        /* Copy the actual board. */
-        board_t *copy = board_copy (board);
+        return best_move;
+    }
 
-        if (copy == NULL)
-        {
-            return (move_t) {.row = MAX_BOARD_SIZE + 1,
-                             .column = MAX_BOARD_SIZE + 1};
-        }
+    deadline = start;
+    deadline.tv_sec += (time_t) time_per_move;
+    deadline.tv_nsec += (time_per_move - (time_t) time_per_move) * 1e9;
 
-        /* Play the next i-th possible moves. */
-        board_play (copy, move);
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
 
-        /* Test if next is game over. */
-        if (board_player (copy) == EMPTY_DISC)
-        {
-            int score = score_heuristic (copy, player_init);
+    time_out = false;
 
-            /* If player init win, just do it. */
-            if (score > 0)
-            {
-                board_free (copy);
-                best_move = move;
+    /* Don't print the progress barre of each depth. */
+    bool is_verbose = search->verbose;
+    search->verbose = false;
 
-                break;
-            }
-            /* If player init lost, don't select this move. */
-            else if (score < 0)
-            {
-                board_free (copy);
+    /* The threads don't split the root of their searches. */
+    size_t helpers_count = search->threads - 1;
+    search->threads = 1;
+    lazy_helper_t *helpers = malloc (helpers_count * sizeof (lazy_helper_t));
+    size_t started = 0;
 
-                continue;
-            }
-            /* Else score = 0, let evaluate it. */
-            else
-            {
-                tampon_ab.beta = score;
-            }
-        }
-        /* Test if it's opponent -> minimisation. */
-        else if (board_player (copy) != player_init)
-        {
-            tampon_ab  = ab_min_used[ai] (copy, depth_ini, result_ab,
-                                          player_init);
-        }
-        /* Test if it's same player -> maximisation. */
-        else
+    while (helpers != NULL && started < helpers_count)
+    {
+        lazy_helper_t *helper = &helpers[started];
+        helper->ai = ai;
+        helper->first_depth = 1 + (started + 1) % 2;
+        helper->search = *search;
+        memset (&helper->search.stats, 0, sizeof (search_stats_t));
+        helper->best_move = best_move;
+        helper->board = board_copy (board);
+
+        if (helper->board == NULL)
         {
-            tampon_ab  = ab_max_used[ai] (copy, depth_ini, result_ab,
-                                          player_init);
+            break;
         }
 
-        /* If alpha >= beta, pass at the next move. */
-        if (tampon_ab.alpha >= tampon_ab.beta)
+        if (pthread_create (&helper->thread, NULL, lazy_smp_helper,
+                            helper) != 0)
         {
-            board_free (copy);
+            board_free (helper->board);
 
-            continue;
+            break;
         }
 
-        /* If beta son > actual alpha, it's a better move. */
-        if (tampon_ab.beta > result_ab.alpha)
+        started++;
+    }
+
+    size_t depth_reached = deepening_loop (search, ai, board, 1, &best_move,
+                                           &start);
+
+    /* Stop the helpers and play the move of the deepest search. */
+    time_out = true;
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join (helpers[i].thread, NULL);
+        board_free (helpers[i].board);
+        stats_add (&search->stats, &helpers[i].search.stats);
+
+        if (helpers[i].depth_reached > depth_reached)
         {
-            /* In max node, beta son become alpha. */
-            result_ab.alpha = tampon_ab.beta;
-            best_move = move;
+            depth_reached = helpers[i].depth_reached;
+            best_move = helpers[i].best_move;
         }
-
-        board_free (copy);
     }
 
-    if (verbose)
+    free (helpers);
+    search->threads = helpers_count + 1;
+    time_out = false;
+    search->verbose = is_verbose;
+
+    if (search->verbose)
     {
-        print_progress (number_max_moves, number_max_moves, player_init);
+        printf ("\033[A\33[2K"); /* Don't write the last printf. */
+        printf ("The AI searched to depth %zu in %.2f seconds.\n",
+                depth_reached, elapsed_since (start));
     }
 
+    stats_report (search, root_search_names[ai], depth_reached, start);
+
     return best_move;
 }
@@ -1,10 +1,18 @@
+#define _POSIX_C_SOURCE 200809L /* To use scandir () and clock_gettime (). */
+
 #include "reversi.h"
 
 #include <ctype.h>
+#include <dirent.h>
 #include <err.h>
 #include <getopt.h>
+#include <time.h>
 
+#include <book_builder.h>
+#include <endgame.h>
+#include <perft.h>
 #include <player.h>
+#include <tt.h>
 
 
 /********************************* Constants **********************************/
@@ -15,6 +23,12 @@ static bool all = false;
 static int contest_ai = 4;
 static int black_ai = 0;
 static int white_ai = 0;
+static size_t perft_depth = 0;
+static size_t perft_threads = 1;
+static size_t hash_size = 16;
+static char *suite_dir = NULL;
+static char *book_file = NULL;
+static size_t book_plies = 0;
 
 /* String description for all possible players */
 static char (*char_player_used[5]) =
@@ -32,7 +46,9 @@ static void
 help ()
 {
     printf ("\n**************** Welcome to the reversi Game *****************\n"
-            "\nUsage: reversi [-s SIZE|-b[N]|-w[N]|-c[N]|-v|-V|-h] [FILE]"
+            "\nUsage: reversi [-s SIZE|-b[N]|-w[N]|-c[N]|-H MB|-t SEC|-e N]"
+            "\n               [-o FILE|-K FILE|-k N|-j N|-p DEPTH|-B DIR|-S]"
+            "\n               [-v|-V|-h] [FILE]"
             "\nPlay a reversi game with human or program players.\n"
             "  -s, --size SIZE\tboard size (min=1, max=5 (default: 4))\n"
             "  -b, --black-ai [N]\tset tactic of black player (default: 0)\n"
@@ -40,6 +56,28 @@ help ()
             "  -c, --contest [N]\tenable 'contest' mode and set it's tactic\n"
             "\t\t\t(default: 4)\n"
             "  -a, --all \t\tpermit to parse all files\n"
+            "  -H, --hash MB\t\tmemory of the AI transposition table (and of\n"
+            "\t\t\tthe perft hash table), 0 to disable it\n"
+            "\t\t\t(default: 16)\n"
+            "  -t, --time-per-move SEC\tsearch the AI moves by iterative\n"
+            "\t\t\tdeepening in SEC seconds (default: fixed depth)\n"
+            "  -e, --endgame N\tplay perfectly the last N empty squares with\n"
+            "\t\t\tthe AI 3 and 4, 0 to disable it (default: 14)\n"
+            "  -o, --book FILE\tplay the moves of the opening book FILE with\n"
+            "\t\t\tthe AI 3 and 4\n"
+            "  -K, --build-book FILE\tbuild (or extend) the opening book\n"
+            "\t\t\tFILE of the board size and exit\n"
+            "  -k, --book-plies N\tplies of the opening tree of the book\n"
+            "\t\t\t(default: 6, 4 for the 10x10 board)\n"
+            "  -j, --threads N\tsearch the moves of the AI 3 and 4 (or count\n"
+            "\t\t\tthe perft leaves, or search the leaves of the\n"
+            "\t\t\tbook) with N threads (default: 1)\n"
+            "  -p, --perft DEPTH\tcount the leaves of the game tree of the\n"
+            "\t\t\tstart position or FILE up to DEPTH and exit\n"
+            "  -B, --bench-suite DIR\tsolve the endgame positions of DIR,\n"
+            "\t\t\tcheck their score and move and exit\n"
+            "  -S, --stats\t\tprint the statistics of each AI search as a\n"
+            "\t\t\tJSON line\n"
             "  -v, --verbose\t\tverbose output\n"
             "  -V, --version\t\tdisplay version and exit\n"
             "  -h, --help\t\tdisplay this help and exit\n"
@@ -414,6 +452,169 @@ game (move_t (*black) (board_t *), move_t (*white) (board_t *), board_t *board)
 }
 
 
+/****************************** Benchmark suite *******************************/
+
+/* Name of 'move' as the contest mode print it (column letter and row). */
+static void
+move_name (const move_t move, char name[4])
+{
+    snprintf (name, 4, "%c%zu", (char) ('a' + move.column), move.row + 1);
+}
+
+/* Read the expected answer of the position of the file 'filename' in its
+ * comments "# score: SCORE" and "# moves: MOVE..." (all the best moves)
+ *   -> return false if one of them is missing. */
+static bool
+suite_expected (const char *filename, int *score, char *moves,
+                const size_t length)
+{
+    FILE *file = fopen (filename, "r");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    char line[256];
+    bool has_score = false;
+    bool has_moves = false;
+
+    while (fgets (line, sizeof (line), file) != NULL)
+    {
+        if (sscanf (line, "# score: %d", score) == 1)
+        {
+            has_score = true;
+        }
+        else if (strncmp (line, "# moves:", 8) == 0)
+        {
+            snprintf (moves, length, "%s", line + 8);
+            moves[strcspn (moves, "\n")] = '\0';
+            has_moves = true;
+        }
+    }
+
+    fclose (file);
+
+    return has_score && has_moves;
+}
+
+/* Tell if 'name' is one of the moves of the list 'moves'. */
+static bool
+suite_has_move (const char *moves, const char *name)
+{
+    size_t length = strlen (name);
+
+    for (const char *move = moves; *move != '\0'; move++)
+    {
+        if (strncmp (move, name, length) == 0 &&
+            (move == moves || move[-1] == ' ') &&
+            (move[length] == '\0' || move[length] == ' '))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Keep the position files of a suite (not the hidden ones). */
+static int
+suite_file (const struct dirent *entry)
+{
+    return entry->d_name[0] != '.';
+}
+
+/* Solve with the endgame solver each position of the directory 'dir' (in the
+ * order of their names), print its time, nodes and nodes per second and
+ * check its score and move against the answer in its comments
+ *   -> return false if a position can't be read or is not solved right. */
+static bool
+bench_suite (const char *dir)
+{
+    struct dirent **entries;
+    int count = scandir (dir, &entries, suite_file, alphasort);
+
+    if (count < 0)
+    {
+        warnx ("Error: The directory %s can't be open.", dir);
+
+        return false;
+    }
+
+    tt_t *tt = (hash_size > 0) ? tt_alloc (hash_size) : NULL;
+    size_t solved = 0;
+    size_t total_nodes = 0;
+    double total_time = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        char filename[4096];
+        char expected_moves[256];
+        int expected_score;
+        snprintf (filename, sizeof (filename), "%s/%s", dir,
+                  entries[i]->d_name);
+        board_t *board = file_parser (filename);
+
+        if (board == NULL ||
+            !suite_expected (filename, &expected_score, expected_moves,
+                             sizeof (expected_moves)))
+        {
+            warnx ("Impossible to read the position and the answer of %s.",
+                   filename);
+            board_free (board);
+
+            continue;
+        }
+
+        /* Each position is solved from an empty table. */
+        tt_clear (tt);
+
+        struct timespec start;
+        struct timespec end;
+        size_t nodes = 0;
+        int score = 0;
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        move_t move = endgame_best_move (board, tt, &score, &nodes);
+        clock_gettime (CLOCK_MONOTONIC, &end);
+
+        double seconds = (end.tv_sec - start.tv_sec) +
+                         (end.tv_nsec - start.tv_nsec) / 1e9;
+        score_t discs = board_score (board);
+        size_t empties = board_size (board) * board_size (board) -
+                         discs.black - discs.white;
+        char name[4];
+        move_name (move, name);
+        bool ok = move.row < board_size (board) && score == expected_score &&
+                  suite_has_move (expected_moves, name);
+
+        printf ("%-12s %3zu empties  %8.3f s %12zu nodes %10.0f nodes/s  "
+                "move %-3s score %+3d  %-5s (expected %+d:%s)\n",
+                entries[i]->d_name, empties, seconds, nodes,
+                (seconds > 0) ? nodes / seconds : 0.0, name, score,
+                ok ? "ok" : "WRONG", expected_score, expected_moves);
+
+        solved += ok;
+        total_nodes += nodes;
+        total_time += seconds;
+        board_free (board);
+    }
+
+    printf ("%zu/%d positions solved right  %8.3f s %12zu nodes %10.0f "
+            "nodes/s\n", solved, count, total_time, total_nodes,
+            (total_time > 0) ? total_nodes / total_time : 0.0);
+
+    for (int i = 0; i < count; i++)
+    {
+        free (entries[i]);
+    }
+
+    free (entries);
+    tt_free (tt);
+
+    return solved == (size_t) count;
+}
+
+
 /************************************ Main ************************************/
 
 int
@@ -421,7 +622,7 @@ main (int argc, char* argv[])
 {
     int optc;
     size_t board_size = 8;
-    char *op = "b::w::s:c::avVh";
+    char *op = "b::w::s:c::aH:t:e:o:K:k:j:p:B:SvVh";
 
     struct option long_opts[] =
     {
@@ -430,6 +631,16 @@ main (int argc, char* argv[])
         {"size", required_argument, NULL, 's'},
         {"contest", optional_argument, NULL, 'c'},
         {"all", no_argument, NULL, 'a'},
+        {"hash", required_argument, NULL, 'H'},
+        {"time-per-move", required_argument, NULL, 't'},
+        {"endgame", required_argument, NULL, 'e'},
+        {"book", required_argument, NULL, 'o'},
+        {"build-book", required_argument, NULL, 'K'},
+        {"book-plies", required_argument, NULL, 'k'},
+        {"threads", required_argument, NULL, 'j'},
+        {"perft", required_argument, NULL, 'p'},
+        {"bench-suite", required_argument, NULL, 'B'},
+        {"stats", no_argument, NULL, 'S'},
         {"verbose", no_argument, NULL, 'v'},
         {"version", no_argument, NULL, 'V'},
         {"help", no_argument, NULL, 'h'},
@@ -503,6 +714,109 @@ main (int argc, char* argv[])
 
                 break;
 
+            case 'H' :
+                if (isdigit (*optarg) == 0 || atoi (optarg) > 4096)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a hash size in [0,..,4096] MB.\n");
+                }
+
+                set_hash_size (atoi (optarg));
+                hash_size = atoi (optarg);
+
+                break;
+
+            case 't' :
+            {
+                char *end;
+                double seconds = strtod (optarg, &end);
+
+                if (end == optarg || *end != '\0' || seconds <= 0)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a positive time per move.\n");
+                }
+
+                set_time_per_move (seconds);
+
+                break;
+            }
+
+            case 'e' :
+                if (isdigit (*optarg) == 0 ||
+                    atoi (optarg) > MAX_BOARD_SIZE * MAX_BOARD_SIZE)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a number of empties in [0,..,%d].\n",
+                          MAX_BOARD_SIZE * MAX_BOARD_SIZE);
+                }
+
+                set_endgame_empties (atoi (optarg));
+
+                break;
+
+            case 'o' :
+                if (!set_book (optarg))
+                {
+                    errx (EXIT_FAILURE, "'%s' is not an opening book.\n",
+                          optarg);
+                }
+
+                break;
+
+            case 'K' :
+                book_file = optarg;
+
+                break;
+
+            case 'k' :
+                if (isdigit (*optarg) == 0 || atoi (optarg) < 1 ||
+                    atoi (optarg) > 20)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a number of plies in [1,..,20].\n");
+                }
+
+                book_plies = atoi (optarg);
+
+                break;
+
+            case 'j' :
+                if (isdigit (*optarg) == 0 || atoi (optarg) < 1 ||
+                    atoi (optarg) > 256)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a number of threads in [1,..,256].\n");
+                }
+
+                set_threads (atoi (optarg));
+                perft_threads = atoi (optarg);
+
+                break;
+
+            case 'p' :
+                if (isdigit (*optarg) == 0 || atoi (optarg) < 1 ||
+                    atoi (optarg) > MAX_BOARD_SIZE * MAX_BOARD_SIZE)
+                {
+                    errx (EXIT_FAILURE,
+                          "Please select a perft depth in [1,..,%d].\n",
+                          MAX_BOARD_SIZE * MAX_BOARD_SIZE);
+                }
+
+                perft_depth = atoi (optarg);
+
+                break;
+
+            case 'B' :
+                suite_dir = optarg;
+
+                break;
+
+            case 'S' :
+                set_stats ();
+
+                break;
+
             case 'v' :
                 verbose = true;
                 set_verbose ();
@@ -529,6 +843,63 @@ main (int argc, char* argv[])
     int i = optind;
     bool error = false;
 
+    /* Benchmark suite mode: only solve the positions of the directory. */
+    if (suite_dir != NULL)
+    {
+        return (bench_suite (suite_dir)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Book mode: only build the opening book of the board size. */
+    if (book_file != NULL)
+    {
+        size_t plies, depth;
+
+        if (!book_defaults (board_size, &plies, &depth))
+        {
+            errx (EXIT_FAILURE, "There is no book of size %zu.\n",
+                  board_size);
+        }
+
+        /* The leaves are searched to a fixed depth. */
+        set_time_per_move (0);
+        plies = (book_plies > 0) ? book_plies : plies;
+
+        return (book_build (book_file, board_size, plies, depth,
+                            perft_threads, stdout)) ? EXIT_SUCCESS :
+                                                      EXIT_FAILURE;
+    }
+
+    /* Perft mode: only count the leaves of the game tree. */
+    if (perft_depth > 0)
+    {
+        int max = (all && i < argc) ? argc : i + 1;
+
+        for (int j = i; j < max; j++)
+        {
+            board = (i == argc) ? board_init (board_size) :
+                                  file_parser (argv[j]);
+
+            if (board == NULL)
+            {
+                error = true;
+                warnx ("Impossible to get the board to count.\n");
+
+                continue;
+            }
+
+            if (!perft_run (board, perft_depth, perft_threads,
+                            hash_size, stdout))
+            {
+                error = true;
+                warnx ("The leaves differ from the reference counts.\n");
+            }
+
+            board_free (board);
+        }
+
+        return (error) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
     if (i == argc) /* If no file in argument. */
     {
         if (contest_mode)
@@ -0,0 +1,229 @@
+#include <tt.h>
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/********************************* Constants **********************************/
+
+/* Number of entries of a bucket: a bucket fill a 64 bytes cache line. */
+#define BUCKET_ENTRIES 4
+
+/* Encoding of 'no move' in an entry. */
+#define NO_MOVE 0xFF
+
+/* Position of the fields in the data of an entry. */
+#define SCORE_SHIFT 0
+#define DEPTH_SHIFT 16
+#define BOUND_SHIFT 24
+#define MOVE_SHIFT 32
+#define GENERATION_SHIFT 40
+
+
+/********************************* Structures *********************************/
+
+/* An entry of 16 bytes: the data (score, depth, bound, move and generation)
+ * packed in 64 bits and the hash of the position xor the data. The threads
+ * read and write the entries without lock: an entry written by two threads
+ * at the same time mix their key and data, and it is then never found. */
+typedef struct
+{
+    _Atomic uint64_t key;
+    _Atomic uint64_t data;
+} entry_t;
+
+/* All the entries that can store a position, on a single cache line. */
+typedef struct
+{
+    _Alignas (64) entry_t entries[BUCKET_ENTRIES];
+} bucket_t;
+
+/* Internal tt_t structure (hiden from the outside). */
+struct tt_t
+{
+    bucket_t *buckets;
+    size_t mask;        /* Number of buckets - 1 (a power of 2). */
+    uint8_t generation; /* Generation of the current search. */
+};
+
+
+/******************************* Entries access *******************************/
+
+/* Read the key and the data of 'entry' (maybe written by another thread). */
+static void
+entry_load (const entry_t *entry, uint64_t *key, uint64_t *data)
+{
+    *data = atomic_load_explicit (&entry->data, memory_order_relaxed);
+    *key = atomic_load_explicit (&entry->key, memory_order_relaxed);
+}
+
+/* Field of 'data' at 'shift'. */
+static uint8_t
+data_field (const uint64_t data, const size_t shift)
+{
+    return (data >> shift) & 0xFF;
+}
+
+/********************** Transposition table management **********************/
+
+tt_t*
+tt_alloc (const size_t megabytes)
+{
+    size_t count = 1;
+
+    /* The biggest power of 2 of buckets that fit in the budget. */
+    while (count * 2 * sizeof (bucket_t) <= megabytes * 1024 * 1024)
+    {
+        count *= 2;
+    }
+
+    tt_t *tt = malloc (sizeof (tt_t));
+
+    if (tt == NULL)
+    {
+        return NULL;
+    }
+
+    tt->buckets = aligned_alloc (sizeof (bucket_t), count * sizeof (bucket_t));
+
+    if (tt->buckets == NULL)
+    {
+        free (tt);
+
+        return NULL;
+    }
+
+    tt->mask = count - 1;
+    tt_clear (tt);
+
+    return tt;
+}
+
+void
+tt_free (tt_t *tt)
+{
+    if (tt == NULL)
+    {
+        return;
+    }
+
+    free (tt->buckets);
+    free (tt);
+}
+
+void
+tt_clear (tt_t *tt)
+{
+    if (tt == NULL)
+    {
+        return;
+    }
+
+    memset (tt->buckets, 0, (tt->mask + 1) * sizeof (bucket_t));
+    tt->generation = 0;
+}
+
+void
+tt_new_search (tt_t *tt)
+{
+    if (tt == NULL)
+    {
+        return;
+    }
+
+    tt->generation++;
+}
+
+bool
+tt_probe (const tt_t *tt, const uint64_t hash, tt_data_t *data)
+{
+    if (tt == NULL || data == NULL)
+    {
+        return false;
+    }
+
+    const bucket_t *bucket = &tt->buckets[hash & tt->mask];
+
+    for (size_t i = 0; i < BUCKET_ENTRIES; i++)
+    {
+        uint64_t key;
+        uint64_t entry;
+        entry_load (&bucket->entries[i], &key, &entry);
+
+        /* An empty entry has a depth of 0 (never stored). */
+        if ((key ^ entry) != hash || data_field (entry, DEPTH_SHIFT) == 0)
+        {
+            continue;
+        }
+
+        uint8_t move = data_field (entry, MOVE_SHIFT);
+
+        data->score = (int16_t) (entry >> SCORE_SHIFT);
+        data->depth = data_field (entry, DEPTH_SHIFT);
+        data->bound = data_field (entry, BOUND_SHIFT);
+        data->move = (move == NO_MOVE) ?
+                     (move_t) {.row = MAX_BOARD_SIZE,
+                               .column = MAX_BOARD_SIZE} :
+                     (move_t) {.row = move / MAX_BOARD_SIZE,
+                               .column = move % MAX_BOARD_SIZE};
+
+        return true;
+    }
+
+    return false;
+}
+
+void
+tt_store (tt_t *tt, const uint64_t hash, const tt_data_t *data)
+{
+    if (tt == NULL || data == NULL || data->depth == 0)
+    {
+        return;
+    }
+
+    bucket_t *bucket = &tt->buckets[hash & tt->mask];
+    entry_t *replaced = &bucket->entries[0];
+    uint8_t replaced_depth = UINT8_MAX;
+    bool replaced_old = false;
+
+    /* Take the entry of the same position if any, else the entry of an older
+     * search, else the shallowest entry. */
+    for (size_t i = 0; i < BUCKET_ENTRIES; i++)
+    {
+        uint64_t key;
+        uint64_t entry;
+        entry_load (&bucket->entries[i], &key, &entry);
+
+        if ((key ^ entry) == hash)
+        {
+            replaced = &bucket->entries[i];
+
+            break;
+        }
+
+        uint8_t depth = data_field (entry, DEPTH_SHIFT);
+        bool old = data_field (entry, GENERATION_SHIFT) != tt->generation;
+
+        if (i == 0 || (old && !replaced_old) ||
+            (old == replaced_old && depth < replaced_depth))
+        {
+            replaced = &bucket->entries[i];
+            replaced_depth = depth;
+            replaced_old = old;
+        }
+    }
+
+    uint64_t depth = (data->depth > UINT8_MAX) ? UINT8_MAX : data->depth;
+    uint64_t move = (data->move.row >= MAX_BOARD_SIZE ||
+                     data->move.column >= MAX_BOARD_SIZE) ? NO_MOVE :
+                    data->move.row * MAX_BOARD_SIZE + data->move.column;
+    uint64_t entry = ((uint64_t) (uint16_t) data->score << SCORE_SHIFT) |
+                     (depth << DEPTH_SHIFT) |
+                     ((uint64_t) data->bound << BOUND_SHIFT) |
+                     (move << MOVE_SHIFT) |
+                     ((uint64_t) tt->generation << GENERATION_SHIFT);
+
+    atomic_store_explicit (&replaced->key, hash ^ entry, memory_order_relaxed);
+    atomic_store_explicit (&replaced->data, entry, memory_order_relaxed);
+}